@@ -0,0 +1,179 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "hand_rank.h"
+#include "solvable_table.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//blocked bloom filter over every solvable (hand, integer target) pair of a
+//SolvableTable's ranges. a key sets PROBES bits inside one 64-byte block, so a
+//query costs one cache miss: any bit clear means the pair is certainly unsolvable,
+//all set means "probably solvable" and the caller goes on to a table or a search.
+//the file (a 64-byte header starting "S24F", then the blocks) is memory-mapped when
+//loaded, so many processes share one copy in the page cache. the header is padded so
+//every block of a mapping, like every block built in memory, starts on a cache line
+class SolvableFilter{
+private:
+    static const int PROBES = 7;
+    static const int BLOCK_WORDS = 8;
+    static const size_t HEADER_BYTES = 64;
+    //"S24B" files had a 44-byte header, which left no block aligned; they are not read
+    static const uint32_t FORMAT_VERSION = 2;
+
+    int cards;
+    int max_value;
+    long long min_target;
+    long long max_target;
+    uint64_t block_count;
+    std::vector<uint64_t> owned;
+    const uint64_t* blocks;
+    void* mapping;
+    size_t mapping_bytes;
+
+    static uint64_t mix(uint64_t h){
+        h ^= h >> 33; h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+    static uint64_t key_of(uint64_t rank, long long target){
+        return mix(rank * 0x9E3779B97F4A7C15ULL ^ mix((uint64_t)target + 0x632BE59BD9B4E019ULL));
+    }
+    //block from the high half; probe positions are 9-bit slices of the low half and a remix
+    void set(uint64_t* words, uint64_t key){
+        uint64_t* block = words + (key >> 32) % block_count * BLOCK_WORDS;
+        uint64_t bits = key ^ mix(key);
+        for(int i = 0; i < PROBES; i++, bits >>= 9) block[(bits >> 6) & 7] |= 1ULL << (bits & 63);
+    }
+    bool test(uint64_t key) const {
+        const uint64_t* block = blocks + (key >> 32) % block_count * BLOCK_WORDS;
+        uint64_t bits = key ^ mix(key);
+        for(int i = 0; i < PROBES; i++, bits >>= 9)
+            if(!(block[(bits >> 6) & 7] & (1ULL << (bits & 63)))) return false;
+        return true;
+    }
+    //zeroed storage for the blocks in owned, starting on a 64-byte boundary
+    uint64_t* allocate(size_t words){
+        owned.assign(words + BLOCK_WORDS - 1, 0);
+        uint64_t* aligned = (uint64_t*)(((uintptr_t)owned.data() + 63) & ~(uintptr_t)63);
+        blocks = aligned;
+        return aligned;
+    }
+    SolvableFilter() : cards(0), max_value(0), min_target(0), max_target(0), block_count(0), blocks(nullptr), mapping(nullptr), mapping_bytes(0) {}
+public:
+    //bits_per_key 10 gives roughly a 1% false-positive rate
+    SolvableFilter(const SolvableTable& table, double bits_per_key = 10) : SolvableFilter() {
+        cards = table.get_cards();
+        max_value = table.get_max_value();
+        min_target = table.get_min_target();
+        max_target = table.get_max_target();
+        uint64_t keys = 0;
+        for(uint64_t rank = 0; rank < table.get_hands(); rank++)
+            for(long long t = min_target; t <= max_target; t++) keys += table.is_solvable(rank, t);
+        block_count = (uint64_t)std::ceil(keys * bits_per_key / (BLOCK_WORDS * 64)) + 1;
+        uint64_t* words = allocate(block_count * BLOCK_WORDS);
+        for(uint64_t rank = 0; rank < table.get_hands(); rank++)
+            for(long long t = min_target; t <= max_target; t++)
+                if(table.is_solvable(rank, t)) set(words, key_of(rank, t));
+    }
+    ~SolvableFilter(){
+#ifndef _WIN32
+        if(mapping) munmap(mapping, mapping_bytes);
+#endif
+    }
+    SolvableFilter(const SolvableFilter&) = delete;
+    SolvableFilter& operator=(const SolvableFilter&) = delete;
+
+    size_t get_bytes() const { return block_count * BLOCK_WORDS * sizeof(uint64_t); }
+    bool is_mapped() const { return mapping != nullptr; }
+
+    bool covers(const int* hand, size_t count, double target) const {
+        if((int)count != cards || target != std::floor(target) || target < min_target || target > max_target) return false;
+        for(size_t i = 0; i < count; i++)
+            if(hand[i] < 1 || hand[i] > max_value) return false;
+        return true;
+    }
+    //true only when the hand certainly cannot make target; false for "maybe" and for hands out of range
+    bool rejects(const int* hand, size_t count, double target) const {
+        if(count > 8 || !covers(hand, count, target)) return false;
+        //rank_hand without its vector copy: cards is at most 8
+        int sorted[8];
+        std::copy(hand, hand + count, sorted);
+        std::sort(sorted, sorted + count);
+        uint64_t rank = 0;
+        for(int i = 0; i < (int)count; i++) rank += binomial(sorted[i] - 1 + i, i + 1);
+        return !test(key_of(rank, (long long)target));
+    }
+    bool rejects(const std::vector<int>& hand, double target) const { return rejects(hand.data(), hand.size(), target); }
+
+    bool save(const std::string& path) const {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if(!f) return false;
+        char header[HEADER_BYTES] = {};
+        long long fields[5] = {cards, max_value, min_target, max_target, (long long)block_count};
+        std::memcpy(header, "S24F", 4);
+        uint32_t version = FORMAT_VERSION;
+        std::memcpy(header + 4, &version, 4);
+        std::memcpy(header + 8, fields, sizeof(fields));
+        bool ok = std::fwrite(header, HEADER_BYTES, 1, f) == 1
+               && std::fwrite(blocks, sizeof(uint64_t), block_count * BLOCK_WORDS, f) == block_count * BLOCK_WORDS;
+        return std::fclose(f) == 0 && ok;
+    }
+    //maps the file read-only (reads it into memory on windows); nullptr on a missing or malformed file
+    static SolvableFilter* load(const std::string& path){
+        char raw[HEADER_BYTES];
+        long long header[5];
+        uint32_t version = 0;
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if(!f) return nullptr;
+        bool ok = std::fread(raw, HEADER_BYTES, 1, f) == 1 && std::memcmp(raw, "S24F", 4) == 0;
+        if(ok){
+            std::memcpy(&version, raw + 4, 4);
+            std::memcpy(header, raw + 8, sizeof(header));
+        }
+        ok = ok && version == FORMAT_VERSION
+               && header[0] > 0 && header[0] <= 8 && header[1] > 0 && header[2] <= header[3] && header[4] > 0;
+        SolvableFilter* filter = nullptr;
+        if(ok){
+            filter = new SolvableFilter();
+            filter->cards = (int)header[0];
+            filter->max_value = (int)header[1];
+            filter->min_target = header[2];
+            filter->max_target = header[3];
+            filter->block_count = (uint64_t)header[4];
+            size_t words = filter->block_count * BLOCK_WORDS;
+#ifndef _WIN32
+            //map the whole file and point past the header: 64 bytes into a page-aligned
+            //mapping, so the blocks stay cache-line aligned
+            size_t bytes = HEADER_BYTES + words * sizeof(uint64_t);
+            struct stat st;
+            void* p = MAP_FAILED;
+            if(fstat(fileno(f), &st) == 0 && (size_t)st.st_size >= bytes)
+                p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fileno(f), 0);
+            if(p != MAP_FAILED){
+                filter->mapping = p;
+                filter->mapping_bytes = bytes;
+                filter->blocks = (const uint64_t*)((const char*)p + HEADER_BYTES);
+            }
+#endif
+            if(!filter->mapping){
+                if(std::fread(filter->allocate(words), sizeof(uint64_t), words, f) != words){
+                    delete filter;
+                    filter = nullptr;
+                }
+            }
+        }
+        std::fclose(f);
+        return filter;
+    }
+};
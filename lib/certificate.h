@@ -0,0 +1,376 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "rational.h"
+#include "reachable.h"
+
+//unsolvability certificates. a certificate lists, for every proper sub-hand of two or
+//more numbers, a set of values that contains everything that sub-hand can make (the
+//reach:: DP tables). the checker needs no search: it confirms each set is closed under
+//the splits of its sub-hand, then shows no split of the full hand can meet the target by
+//solving a op b = target for b and binary-searching the other side. the full hand's own
+//value set, the largest table by far, is never built or stored.
+//encoding: "S24C", then varints: n, the numbers, the target as num/den, and per
+//sub-hand mask (increasing, two or more bits, not the full mask) a count and the
+//sorted values, numerators zigzag-coded
+namespace cert{
+
+inline void put_varint(std::string& out, uint64_t v){
+    while(v >= 0x80){
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+inline bool get_varint(const std::string& in, size_t& at, uint64_t& v){
+    v = 0;
+    for(int shift = 0; shift < 64 && at < in.size(); shift += 7){
+        uint8_t byte = (uint8_t)in[at++];
+        v |= (uint64_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) return true;
+    }
+    return false;
+}
+inline void put_rational(std::string& out, const Rational& r){
+    put_varint(out, ((uint64_t)r.num << 1) ^ (uint64_t)(r.num >> 63));
+    put_varint(out, (uint64_t)r.den);
+}
+inline bool get_rational(const std::string& in, size_t& at, Rational& r){
+    uint64_t num, den;
+    if(!get_varint(in, at, num) || !get_varint(in, at, den) || den == 0 || den > (uint64_t)INT64_MAX) return false;
+    long long n = (long long)(num >> 1) ^ -(long long)(num & 1);
+    //canonical form only, so equal values compare equal
+    return Rational::make(n, (long long)den, r) && r.num == n && r.den == (long long)den;
+}
+
+//exact value of target when it is a fraction with a power-of-two denominator up to 2^20
+//(every integer and most decimals the game produces); false otherwise
+inline bool exact_target(double target, Rational& out){
+    double scaled = target;
+    long long den = 1;
+    while(scaled != std::floor(scaled) && den < (1LL << 20)){
+        scaled *= 2;
+        den *= 2;
+    }
+    if(scaled != std::floor(scaled) || std::fabs(scaled) > 1e15) return false;
+    return Rational::make((long long)scaled, den, out);
+}
+
+//true when some a in left and b in right combine to target, from either side
+inline bool meets_target(const reach::ValueSet& left, const reach::ValueSet& right, const Rational& t){
+    auto has = [&](const Rational& b){ return std::binary_search(right.begin(), right.end(), b); };
+    auto has_nonzero = [&](){ return right.size() > 1 || (right.size() == 1 && right[0].num != 0); };
+    Rational b;
+    for(size_t i = 0; i < left.size(); i++){
+        const Rational& a = left[i];
+        if(sub(t, a, b) && has(b)) return true;            //a + b
+        if(sub(a, t, b) && has(b)) return true;            //a - b
+        if(add(t, a, b) && has(b)) return true;            //b - a
+        if(mul(t, a, b) && a.num != 0 && has(b)) return true; //b / a
+        if(a.num != 0){
+            if(div(t, a, b) && has(b)) return true;        //a * b
+            if(t.num != 0 && div(a, t, b) && has(b)) return true; //a / b
+        }
+        else{
+            if(t.num == 0 && !right.empty()) return true;  //0 * b
+            if(t.num == 0 && has_nonzero()) return true;   //0 / b
+        }
+    }
+    return false;
+}
+
+//builds the certificate for numbers and target into out; false when the target is
+//reachable (there is nothing to certify) or cannot be represented exactly
+inline bool build(const std::vector<int>& numbers, double target, std::string& out){
+    Rational t;
+    if(numbers.empty() || numbers.size() > 12 || !exact_target(target, t)) return false;
+    std::vector<Rational> nums = reach::to_rationals(numbers);
+    uint32_t full = (1u << nums.size()) - 1;
+    if(nums.size() == 1){
+        if(nums[0] == t) return false;
+    }
+    else{
+        std::vector<reach::ValueSet> values = reach::subset_tables(nums, false);
+        bool reachable = false;
+        reach::for_each_split(full, [&](uint32_t left, uint32_t right){
+            if(!reachable) reachable = meets_target(values[left], values[right], t);
+        });
+        if(reachable) return false;
+        out.assign("S24C");
+        put_varint(out, nums.size());
+        for(size_t i = 0; i < nums.size(); i++) put_rational(out, nums[i]);
+        put_rational(out, t);
+        for(uint32_t mask = 1; mask < full; mask++){
+            if((mask & (mask - 1)) == 0) continue;
+            put_varint(out, values[mask].size());
+            for(size_t i = 0; i < values[mask].size(); i++) put_rational(out, values[mask][i]);
+        }
+        return true;
+    }
+    out.assign("S24C");
+    put_varint(out, 1);
+    put_rational(out, nums[0]);
+    put_rational(out, t);
+    return true;
+}
+
+//the independent checker: true only if the certificate proves its target unreachable from
+//its numbers. numbers and target (optional) receive what it is about
+inline bool verify(const std::string& bytes, std::vector<int>* numbers = nullptr, Rational* target = nullptr){
+    size_t at = 4;
+    uint64_t n;
+    if(bytes.compare(0, 4, "S24C") != 0 || !get_varint(bytes, at, n) || n == 0 || n > 12) return false;
+    uint32_t full = (1u << n) - 1;
+    std::vector<reach::ValueSet> values(full);
+    std::vector<Rational> nums(n);
+    Rational t;
+    for(uint64_t i = 0; i < n; i++)
+        if(!get_rational(bytes, at, nums[i]) || !nums[i].is_integer()) return false;
+    if(!get_rational(bytes, at, t)) return false;
+    if(n > 1)
+        for(uint64_t i = 0; i < n; i++) values[1u << i].push_back(nums[i]);
+    for(uint32_t mask = 1; mask < full; mask++){
+        if((mask & (mask - 1)) == 0) continue;
+        uint64_t count;
+        if(!get_varint(bytes, at, count) || count > bytes.size()) return false;
+        reach::ValueSet& set = values[mask];
+        set.resize(count);
+        for(uint64_t i = 0; i < count; i++){
+            if(!get_rational(bytes, at, set[i])) return false;
+            if(i > 0 && !(set[i - 1] < set[i])) return false;
+        }
+    }
+    if(at != bytes.size()) return false;
+    //closure: every value a split can make is listed. an overflowing combination
+    //cannot be checked, so it fails the certificate rather than being skipped
+    bool closed = true;
+    for(uint32_t mask = 1; mask < full && closed; mask++){
+        if((mask & (mask - 1)) == 0) continue;
+        const reach::ValueSet& set = values[mask];
+        reach::for_each_split(mask, [&](uint32_t left, uint32_t right){
+            const reach::ValueSet& a = values[left];
+            const reach::ValueSet& b = values[right];
+            for(size_t i = 0; i < a.size() && closed; i++)
+                for(size_t j = 0; j < b.size() && closed; j++){
+                    Rational r[6];
+                    bool ok[6] = {add(a[i], b[j], r[0]), mul(a[i], b[j], r[1]), sub(a[i], b[j], r[2]), sub(b[j], a[i], r[3]),
+                                  b[j].num == 0 || div(a[i], b[j], r[4]), a[i].num == 0 || div(b[j], a[i], r[5])};
+                    for(int k = 0; k < 6 && closed; k++){
+                        if(!ok[k]) closed = false;
+                        else if((k == 4 && b[j].num == 0) || (k == 5 && a[i].num == 0)) continue;
+                        else if(!std::binary_search(set.begin(), set.end(), r[k])) closed = false;
+                    }
+                }
+        });
+    }
+    if(!closed) return false;
+    bool reachable = n == 1 && nums[0] == t;
+    if(n > 1){
+        reach::for_each_split(full, [&](uint32_t left, uint32_t right){
+            if(!reachable) reachable = meets_target(values[left], values[right], t);
+        });
+    }
+    if(reachable) return false;
+    if(numbers){
+        numbers->clear();
+        for(uint64_t i = 0; i < n; i++) numbers->push_back((int)nums[i].num);
+    }
+    if(target) *target = t;
+    return true;
+}
+
+//certificates by canonical hand: the most recent capacity of them in memory and, with a
+//directory, one "cert-<sorted numbers>-<target>.s24c" file each so other processes can
+//answer from them. certify builds one on the spot; submit only queues the hand for a
+//background builder (at most queue_limit waiting, the rest dropped and counted), which is
+//what a serving path uses so that no query waits on a certificate. a file that cannot be
+//written is reported on stderr the first time and counted
+class CertificateStore{
+private:
+    typedef std::list<std::pair<std::string, std::string>> Recent;
+    std::string directory;
+    size_t capacity;
+    size_t queue_limit;
+    std::mutex lock;
+    //most recently used first
+    Recent recent;
+    std::unordered_map<std::string, Recent::iterator> index;
+    std::deque<std::pair<std::vector<int>, double>> pending;
+    std::unordered_set<std::string> queued;
+    std::condition_variable work;
+    std::condition_variable idle;
+    std::thread builder;
+    bool stopping;
+    uint64_t dropped;
+    uint64_t write_failures;
+
+    static std::string key_of(std::vector<int> numbers, double target){
+        std::sort(numbers.begin(), numbers.end());
+        std::string key;
+        for(size_t i = 0; i < numbers.size(); i++) key += std::to_string(numbers[i]) + (i + 1 < numbers.size() ? "_" : "");
+        char t[32];
+        std::snprintf(t, sizeof(t), "%.17g", target);
+        return key + "-" + t;
+    }
+    std::string path_of(const std::string& key) const { return directory + "/cert-" + key + ".s24c"; }
+    //call with lock held
+    void keep(const std::string& key, const std::string& bytes){
+        std::unordered_map<std::string, Recent::iterator>::iterator it = index.find(key);
+        if(it != index.end()) recent.erase(it->second);
+        recent.emplace_front(key, bytes);
+        index[key] = recent.begin();
+        while(recent.size() > capacity){
+            index.erase(recent.back().first);
+            recent.pop_back();
+        }
+    }
+    //write under a temporary name and rename, so readers never see half a file
+    bool write(const std::string& key, const std::string& bytes){
+        std::string path = path_of(key), partial = path + ".part";
+        FILE* f = std::fopen(partial.c_str(), "wb");
+        bool ok = f != nullptr;
+        if(f){
+            ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+            ok = std::fclose(f) == 0 && ok;
+            if(!ok || std::rename(partial.c_str(), path.c_str()) != 0){
+                std::remove(partial.c_str());
+                ok = false;
+            }
+        }
+        if(!ok){
+            std::lock_guard<std::mutex> guard(lock);
+            if(write_failures++ == 0) std::fprintf(stderr, "could not write certificate %s\n", path.c_str());
+        }
+        return ok;
+    }
+    //builds, writes and keeps; false if the hand is solvable
+    bool make(const std::vector<int>& numbers, double target, const std::string& key){
+        std::string bytes;
+        if(!build(numbers, target, bytes)) return false;
+        if(!directory.empty()) write(key, bytes);
+        std::lock_guard<std::mutex> guard(lock);
+        keep(key, bytes);
+        return true;
+    }
+    void run(){
+        for(;;){
+            std::pair<std::vector<int>, double> hand;
+            std::string key;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                work.wait(guard, [&]{ return stopping || !pending.empty(); });
+                //what was queued before stopping is still built
+                if(pending.empty()) return;
+                hand = pending.front();
+                pending.pop_front();
+                key = key_of(hand.first, hand.second);
+            }
+            make(hand.first, hand.second, key);
+            std::lock_guard<std::mutex> guard(lock);
+            queued.erase(key);
+            if(queued.empty()) idle.notify_all();
+        }
+    }
+public:
+    CertificateStore(std::string arg1 = "", size_t arg2 = 4096, size_t arg3 = 256)
+        : directory(arg1), capacity(arg2 > 0 ? arg2 : 1), queue_limit(arg3), stopping(false), dropped(0), write_failures(0) {}
+    ~CertificateStore(){
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        work.notify_all();
+        if(builder.joinable()) builder.join();
+    }
+    CertificateStore(const CertificateStore&) = delete;
+    CertificateStore& operator=(const CertificateStore&) = delete;
+
+    std::string get_directory() const { return directory; }
+    //true when files can be created in the directory (or there is none to write)
+    bool check_directory(){
+        if(directory.empty()) return true;
+        std::string probe = directory + "/.cert-probe";
+        FILE* f = std::fopen(probe.c_str(), "wb");
+        if(!f) return false;
+        std::fclose(f);
+        std::remove(probe.c_str());
+        return true;
+    }
+    uint64_t get_write_failures(){
+        std::lock_guard<std::mutex> guard(lock);
+        return write_failures;
+    }
+    //returns once every submitted hand has been built (or found solvable)
+    void wait_idle(){
+        std::unique_lock<std::mutex> guard(lock);
+        idle.wait(guard, [&]{ return queued.empty(); });
+    }
+    //submitted hands not queued because queue_limit were already waiting
+    uint64_t get_dropped(){
+        std::lock_guard<std::mutex> guard(lock);
+        return dropped;
+    }
+
+    //false when there is no certificate for this hand yet
+    bool find(const std::vector<int>& numbers, double target, std::string& out){
+        std::string key = key_of(numbers, target);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            std::unordered_map<std::string, Recent::iterator>::iterator it = index.find(key);
+            if(it != index.end()){
+                recent.splice(recent.begin(), recent, it->second);
+                out = it->second->second;
+                return true;
+            }
+        }
+        if(directory.empty()) return false;
+        FILE* f = std::fopen(path_of(key).c_str(), "rb");
+        if(!f) return false;
+        std::string bytes;
+        char buffer[4096];
+        size_t got;
+        while((got = std::fread(buffer, 1, sizeof(buffer), f)) > 0) bytes.append(buffer, got);
+        std::fclose(f);
+        std::lock_guard<std::mutex> guard(lock);
+        keep(key, bytes);
+        out = bytes;
+        return true;
+    }
+    bool contains(const std::vector<int>& numbers, double target){
+        std::lock_guard<std::mutex> guard(lock);
+        return index.count(key_of(numbers, target)) > 0;
+    }
+    //builds and keeps a certificate now unless one is already kept; false if the hand is solvable
+    bool certify(const std::vector<int>& numbers, double target){
+        if(contains(numbers, target)) return true;
+        return make(numbers, target, key_of(numbers, target));
+    }
+    //queues the hand for the background builder unless it is kept or queued already; returns
+    //at once. a hand that turns out solvable is simply not kept
+    void submit(const std::vector<int>& numbers, double target){
+        std::string key = key_of(numbers, target);
+        std::lock_guard<std::mutex> guard(lock);
+        if(stopping || index.count(key) || queued.count(key)) return;
+        if(pending.size() >= queue_limit){
+            dropped++;
+            return;
+        }
+        queued.insert(key);
+        pending.emplace_back(numbers, target);
+        if(!builder.joinable()) builder = std::thread([this]{ run(); });
+        work.notify_one();
+    }
+};
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+//byte-level helpers and the stop flag for checkpointed searches. a checkpoint is a magic
+//tag, then fixed-width little-endian fields and length-prefixed strings in the order the
+//writer chose; every read is bounds-checked, so a truncated or foreign file just fails
+namespace checkpoint{
+
+//set from a signal handler (SIGTERM) to make a running checkpointed search save and stop
+inline volatile std::sig_atomic_t stop_requested = 0;
+
+inline void put_u64(std::string& out, uint64_t v){
+    for(int i = 0; i < 8; i++) out.push_back((char)(v >> (8 * i)));
+}
+inline void put_double(std::string& out, double v){
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    put_u64(out, bits);
+}
+inline void put_string(std::string& out, const std::string& s){
+    put_u64(out, s.size());
+    out += s;
+}
+
+inline bool get_u64(const std::string& in, size_t& at, uint64_t& v){
+    if(at > in.size() || in.size() - at < 8) return false;
+    v = 0;
+    for(int i = 0; i < 8; i++) v |= (uint64_t)(uint8_t)in[at + i] << (8 * i);
+    at += 8;
+    return true;
+}
+inline bool get_double(const std::string& in, size_t& at, double& v){
+    uint64_t bits;
+    if(!get_u64(in, at, bits)) return false;
+    std::memcpy(&v, &bits, sizeof(v));
+    return true;
+}
+inline bool get_string(const std::string& in, size_t& at, std::string& s){
+    uint64_t size;
+    if(!get_u64(in, at, size) || size > in.size() - at) return false;
+    s.assign(in, at, (size_t)size);
+    at += (size_t)size;
+    return true;
+}
+
+//writes under a temporary name and renames, so a crash mid-write leaves the last good file
+inline bool write_file(const std::string& path, const std::string& bytes){
+    std::string partial = path + ".part";
+    FILE* f = std::fopen(partial.c_str(), "wb");
+    if(!f) return false;
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    ok = std::fclose(f) == 0 && ok;
+    if(!ok || std::rename(partial.c_str(), path.c_str()) != 0){
+        std::remove(partial.c_str());
+        return false;
+    }
+    return true;
+}
+inline bool read_file(const std::string& path, std::string& bytes){
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if(!f) return false;
+    bytes.clear();
+    char buffer[4096];
+    size_t got;
+    while((got = std::fread(buffer, 1, sizeof(buffer), f)) > 0) bytes.append(buffer, got);
+    bool ok = !std::ferror(f);
+    std::fclose(f);
+    return ok;
+}
+
+}
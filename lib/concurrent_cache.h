@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+//result cache shared by every serving thread, keyed by canonical hand (see hand_key).
+//open addressing over 64-byte buckets of three entries, each bucket guarded by a
+//seqlock: readers copy the bucket and retry if its sequence moved, so a lookup is
+//plain loads and never writes shared memory. writers take the bucket with one CAS
+//on the sequence. capacity is fixed; a full bucket evicts its least recently used
+//entry, where "recently" is a per-shard clock that only writes advance and hits
+//refresh when their stamp is stale (approximate LRU that keeps hits read-only
+//in the common case). shards keep the clocks apart so writers don't share a line
+class SharedResultCache{
+private:
+    static const int WAYS = 3;
+    //refresh a hit's stamp only once the clock has moved this far past it
+    static const uint32_t STALE = 1024;
+
+    struct alignas(64) Bucket{
+        std::atomic<uint32_t> sequence;
+        std::atomic<uint32_t> stamps[WAYS];
+        std::atomic<uint64_t> keys[WAYS];
+        std::atomic<uint64_t> values[WAYS];
+    };
+    static_assert(sizeof(Bucket) == 64, "one bucket per cache line");
+
+    struct alignas(64) Shard{
+        std::atomic<uint32_t> clock;
+        std::unique_ptr<Bucket[]> buckets;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    uint64_t shard_mask;
+    uint64_t bucket_mask;
+    int shard_bits;
+
+    static uint64_t mix(uint64_t h){
+        h ^= h >> 33; h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+    Shard& shard_of(uint64_t key) const { return shards[key >> (64 - shard_bits) & shard_mask]; }
+    Bucket& bucket_of(Shard& shard, uint64_t key) const { return shard.buckets[key & bucket_mask]; }
+public:
+    //capacity is rounded up to shards * a power of two of buckets, three entries each
+    SharedResultCache(size_t capacity, int shard_count = 64){
+        shard_bits = 0;
+        while((1 << shard_bits) < shard_count) shard_bits++;
+        if(shard_bits == 0) shard_bits = 1;
+        size_t shard_total = (size_t)1 << shard_bits;
+        size_t per_shard = 1;
+        while(per_shard * WAYS * shard_total < capacity) per_shard <<= 1;
+        shards.reset(new Shard[shard_total]);
+        for(size_t s = 0; s < shard_total; s++){
+            shards[s].clock.store(1, std::memory_order_relaxed);
+            shards[s].buckets.reset(new Bucket[per_shard]);
+            for(size_t b = 0; b < per_shard; b++){
+                Bucket& bucket = shards[s].buckets[b];
+                bucket.sequence.store(0, std::memory_order_relaxed);
+                for(int w = 0; w < WAYS; w++){
+                    bucket.keys[w].store(0, std::memory_order_relaxed);
+                    bucket.values[w].store(0, std::memory_order_relaxed);
+                    bucket.stamps[w].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+        shard_mask = shard_total - 1;
+        bucket_mask = per_shard - 1;
+    }
+    SharedResultCache(const SharedResultCache&) = delete;
+    SharedResultCache& operator=(const SharedResultCache&) = delete;
+
+    size_t capacity() const { return (shard_mask + 1) * (bucket_mask + 1) * WAYS; }
+    size_t get_bytes() const { return (shard_mask + 1) * ((bucket_mask + 1) * sizeof(Bucket) + sizeof(Shard)); }
+
+    //order-independent key of a hand: the sorted numbers, the target and a tag for
+    //whatever else changes the answer (query kind, operator set). never 0
+    static uint64_t hand_key(const int* numbers, size_t count, double target, uint64_t tag){
+        //every number is hashed; past 16 the sort copy goes to the heap
+        int small[16];
+        std::vector<int> large;
+        int* sorted = small;
+        if(count > 16){
+            large.resize(count);
+            sorted = large.data();
+        }
+        std::copy(numbers, numbers + count, sorted);
+        std::sort(sorted, sorted + count);
+        uint64_t h = mix(count ^ (tag * 0x9E3779B97F4A7C15ULL));
+        for(size_t i = 0; i < count; i++) h = mix(h ^ (uint64_t)(uint32_t)sorted[i]);
+        uint64_t bits;
+        std::memcpy(&bits, &target, sizeof(bits));
+        return mix(h ^ bits) | 1;
+    }
+
+    bool lookup(uint64_t key, uint64_t& value) const {
+        Shard& shard = shard_of(key);
+        Bucket& bucket = bucket_of(shard, key);
+        for(;;){
+            uint32_t before = bucket.sequence.load(std::memory_order_acquire);
+            if(before & 1) continue;
+            int found = -1;
+            uint64_t v = 0;
+            for(int w = 0; w < WAYS; w++){
+                if(bucket.keys[w].load(std::memory_order_relaxed) == key){
+                    found = w;
+                    v = bucket.values[w].load(std::memory_order_relaxed);
+                    break;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(bucket.sequence.load(std::memory_order_relaxed) != before) continue;
+            if(found < 0) return false;
+            uint32_t now = shard.clock.load(std::memory_order_relaxed);
+            //a racy refresh at worst stamps another entry; eviction is only approximate anyway
+            if(now - bucket.stamps[found].load(std::memory_order_relaxed) > STALE)
+                bucket.stamps[found].store(now, std::memory_order_relaxed);
+            value = v;
+            return true;
+        }
+    }
+
+    void store(uint64_t key, uint64_t value){
+        Shard& shard = shard_of(key);
+        Bucket& bucket = bucket_of(shard, key);
+        uint32_t sequence = bucket.sequence.load(std::memory_order_relaxed);
+        for(;;){
+            if(!(sequence & 1) && bucket.sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire))
+                break;
+            sequence = bucket.sequence.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        int way = -1;
+        for(int w = 0; w < WAYS && way < 0; w++)
+            if(bucket.keys[w].load(std::memory_order_relaxed) == key) way = w;
+        for(int w = 0; w < WAYS && way < 0; w++)
+            if(bucket.keys[w].load(std::memory_order_relaxed) == 0) way = w;
+        uint32_t now = shard.clock.fetch_add(1, std::memory_order_relaxed) + 1;
+        if(way < 0){
+            way = 0;
+            for(int w = 1; w < WAYS; w++)
+                if(now - bucket.stamps[w].load(std::memory_order_relaxed) > now - bucket.stamps[way].load(std::memory_order_relaxed)) way = w;
+        }
+        bucket.keys[way].store(key, std::memory_order_relaxed);
+        bucket.values[way].store(value, std::memory_order_relaxed);
+        bucket.stamps[way].store(now, std::memory_order_relaxed);
+        bucket.sequence.store(sequence + 2, std::memory_order_release);
+    }
+};
@@ -0,0 +1,354 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "reachable.h"
+
+//countdown-style solving: any subset of the numbers may be used and the answer
+//is the exact target or the closest reachable value. intermediate results must
+//be positive integers (a - b needs a > b, a / b needs b to divide a).
+//
+//tables[mask] holds every value reachable from exactly the numbers in mask,
+//each with one way to build it, so every subset is answered from the same
+//computation. tables are built for subsets of up to n-2 numbers; exact hits on
+//the larger sets are found by meet-in-the-middle, looking up the value each
+//split's other side would need in a per-mask hash index. when nothing is exact the
+//values 1, 2, ... away from the target get the same exact probes, nearest first; only
+//when none of the first RING_STEPS rings hits are the n-1 tables and value-sorted
+//orders built, to find the closest result
+namespace countdown{
+
+const long long VALUE_LIMIT = 1LL << 40;
+//distances from the target tried by exact probes before the full closest search
+const long long RING_STEPS = 4;
+
+struct Entry{
+    long long value;
+    uint32_t left_mask;
+    int left;
+    int right;
+    char op;
+};
+
+struct Result{
+    bool exact = false;
+    long long value = 0;
+    uint32_t mask = 0;
+    std::string expression;
+};
+
+class Solver{
+private:
+    struct Candidate{
+        long long value;
+        uint32_t mask;
+        uint32_t left_mask;
+        int left;
+        int right;
+        char op;
+    };
+
+    std::vector<long long> numbers;
+    std::vector<std::vector<Entry>> tables;
+    std::vector<std::vector<int>> index;
+    mutable std::vector<std::vector<int>> order;
+
+    static size_t slot_of(long long value, size_t slot_mask){
+        return (size_t)((uint64_t)value * 0x9E3779B97F4A7C15ULL >> 20) & slot_mask;
+    }
+
+    //position of value in tables[mask], or -1
+    int find(uint32_t mask, long long value) const {
+        const std::vector<int>& slots = index[mask];
+        const std::vector<Entry>& table = tables[mask];
+        size_t slot_mask = slots.size() - 1;
+        for(size_t h = slot_of(value, slot_mask); slots[h] >= 0; h = (h + 1) & slot_mask)
+            if(table[slots[h]].value == value) return slots[h];
+        return -1;
+    }
+
+    void grow_index(uint32_t mask){
+        std::vector<int>& slots = index[mask];
+        std::vector<int> bigger(slots.size() * 2, -1);
+        size_t slot_mask = bigger.size() - 1;
+        const std::vector<Entry>& table = tables[mask];
+        for(size_t i = 0; i < table.size(); i++){
+            size_t h = slot_of(table[i].value, slot_mask);
+            while(bigger[h] >= 0) h = (h + 1) & slot_mask;
+            bigger[h] = (int)i;
+        }
+        slots.swap(bigger);
+    }
+
+    //adds value to tables[mask] unless it is already there; the first derivation wins
+    void emit(uint32_t mask, long long value, uint32_t left_mask, int left, int right, char op){
+        std::vector<int>& slots = index[mask];
+        std::vector<Entry>& table = tables[mask];
+        size_t slot_mask = slots.size() - 1;
+        size_t h = slot_of(value, slot_mask);
+        for(; slots[h] >= 0; h = (h + 1) & slot_mask)
+            if(table[slots[h]].value == value) return;
+        slots[h] = (int)table.size();
+        table.push_back(Entry{value, left_mask, left, right, op});
+        if(table.size() * 2 > slots.size()) grow_index(mask);
+    }
+
+    void build_mask(uint32_t mask){
+        size_t expected = 0;
+        reach::for_each_split(mask, [&](uint32_t left, uint32_t right){
+            expected += tables[left].size() * tables[right].size();
+        });
+        size_t slots = 16;
+        while(slots < expected) slots <<= 1;
+        index[mask].assign(slots, -1);
+        tables[mask].reserve(expected);
+        reach::for_each_split(mask, [&](uint32_t left, uint32_t right){
+            const std::vector<Entry>& a = tables[left];
+            const std::vector<Entry>& b = tables[right];
+            for(size_t i = 0; i < a.size(); i++){
+                long long x = a[i].value;
+                for(size_t j = 0; j < b.size(); j++){
+                    long long y = b[j].value;
+                    emit(mask, x + y, left, (int)i, (int)j, '+');
+                    if(x > 1 && y > 1 && x <= VALUE_LIMIT / y) emit(mask, x * y, left, (int)i, (int)j, '*');
+                    if(x > y) emit(mask, x - y, left, (int)i, (int)j, '-');
+                    else if(y > x) emit(mask, y - x, right, (int)j, (int)i, '-');
+                    if(y > 1 && x % y == 0) emit(mask, x / y, left, (int)i, (int)j, '/');
+                    else if(x > 1 && y % x == 0) emit(mask, y / x, right, (int)j, (int)i, '/');
+                }
+            }
+        });
+    }
+
+    std::string render(uint32_t mask, int position) const {
+        const Entry& e = tables[mask][position];
+        if(e.op == 0) return std::to_string(e.value);
+        return "(" + render(e.left_mask, e.left) + " " + e.op + " " + render(mask ^ e.left_mask, e.right) + ")";
+    }
+
+    static void consider(Candidate& best, bool& have, long long target, const Candidate& c){
+        if(!have || std::llabs(c.value - target) < std::llabs(best.value - target)){
+            best = c;
+            have = true;
+        }
+    }
+
+    bool built(uint32_t mask) const { return !index[mask].empty(); }
+
+    //true when value is reachable from exactly the numbers in mask, with its expression.
+    //unbuilt masks (the n-1 subsets) are answered by meet-in-the-middle over their splits
+    bool lookup(uint32_t mask, long long value, std::string& expression) const {
+        if(built(mask)){
+            int j = find(mask, value);
+            if(j < 0) return false;
+            expression = render(mask, j);
+            return true;
+        }
+        bool found = false;
+        reach::for_each_split(mask, [&](uint32_t left, uint32_t right){
+            if(!found) found = probe_exact(left, right, value, expression);
+        });
+        return found;
+    }
+
+    //x op y == target for x in the smaller (always built) side and y looked up in the other
+    bool probe_exact(uint32_t lmask, uint32_t rmask, long long target, std::string& expression) const {
+        if(!built(lmask) || (built(rmask) && tables[lmask].size() > tables[rmask].size())) std::swap(lmask, rmask);
+        const std::vector<Entry>& a = tables[lmask];
+        std::string other;
+        for(int i = 0; i < (int)a.size(); i++){
+            long long x = a[i].value;
+            const char* op = nullptr;
+            bool x_first = true;
+            if(target > x && lookup(rmask, target - x, other)) op = "+";
+            else if(x > target && lookup(rmask, x - target, other)) op = "-";
+            else if(lookup(rmask, x + target, other)){ op = "-"; x_first = false; }
+            else if(x > 1 && target % x == 0 && target / x > 1 && lookup(rmask, target / x, other)) op = "*";
+            else if(x % target == 0 && x / target > 1 && lookup(rmask, x / target, other)) op = "/";
+            else if(x > 1 && target <= VALUE_LIMIT / x && lookup(rmask, x * target, other)){ op = "/"; x_first = false; }
+            if(op){
+                std::string mine = render(lmask, i);
+                expression = "(" + (x_first ? mine : other) + " " + op + " " + (x_first ? other : mine) + ")";
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<int>& sorted(uint32_t mask) const {
+        std::vector<int>& o = order[mask];
+        if(o.size() != tables[mask].size()){
+            const std::vector<Entry>& table = tables[mask];
+            o.resize(table.size());
+            for(size_t i = 0; i < o.size(); i++) o[i] = (int)i;
+            std::sort(o.begin(), o.end(), [&](int p, int q){ return table[p].value < table[q].value; });
+        }
+        return o;
+    }
+
+    //rank in sorted(mask) of the first value >= value
+    int lower(uint32_t mask, long long value) const {
+        const std::vector<int>& o = sorted(mask);
+        const std::vector<Entry>& table = tables[mask];
+        return (int)(std::lower_bound(o.begin(), o.end(), value, [&](int p, long long v){ return table[p].value < v; }) - o.begin());
+    }
+
+    //calls visit(position) on the entries of tables[mask] around value: the last one
+    //below it and the first two at or above it (value may be a rounded-down quotient)
+    template<class Visit>
+    void near(uint32_t mask, long long value, Visit&& visit) const {
+        const std::vector<int>& o = sorted(mask);
+        int k = lower(mask, value);
+        if(k > 0) visit(o[k - 1]);
+        if(k < (int)o.size()) visit(o[k]);
+        if(k + 1 < (int)o.size()) visit(o[k + 1]);
+    }
+
+    //closest a op b to target over one split of the full mask, when nothing is exact.
+    //nothing nearer than floor is reachable, so a best that close ends the search
+    void probe_closest(uint32_t full, uint32_t lmask, uint32_t rmask, long long target, long long floor, Candidate& best, bool& have) const {
+        const std::vector<Entry>& a = tables[lmask];
+        const std::vector<Entry>& b = tables[rmask];
+        for(int i = 0; i < (int)a.size(); i++){
+            if(have && std::llabs(best.value - target) <= floor) return;
+            long long x = a[i].value;
+            //a + b, a * b and b - a increase with b; a - b decreases
+            near(rmask, target - x, [&](int j){ consider(best, have, target, Candidate{x + b[j].value, full, lmask, i, j, '+'}); });
+            if(x > 1) near(rmask, target / x, [&](int j){
+                long long y = b[j].value;
+                if(y > 1 && y <= VALUE_LIMIT / x) consider(best, have, target, Candidate{x * y, full, lmask, i, j, '*'});
+            });
+            near(rmask, x - target, [&](int j){
+                if(x > b[j].value) consider(best, have, target, Candidate{x - b[j].value, full, lmask, i, j, '-'});
+            });
+            near(rmask, target + x, [&](int j){
+                if(b[j].value > x) consider(best, have, target, Candidate{b[j].value - x, full, rmask, j, i, '-'});
+            });
+        }
+        //quotients need divisibility, so walk outward from the real-valued divisor
+        //x / target until the quotient can no longer beat the best distance
+        for(int side = 0; side < 2; side++){
+            uint32_t num_mask = side == 0 ? lmask : rmask;
+            uint32_t den_mask = side == 0 ? rmask : lmask;
+            const std::vector<Entry>& num = tables[num_mask];
+            const std::vector<Entry>& den = tables[den_mask];
+            const std::vector<int>& o = sorted(den_mask);
+            for(int i = 0; i < (int)num.size(); i++){
+                long long x = num[i].value;
+                long long distance = have ? std::llabs(best.value - target) : VALUE_LIMIT;
+                if(distance <= floor) return;
+                int start = lower(den_mask, target > 0 ? x / target : x);
+                for(int k = start; k < (int)o.size(); k++){
+                    long long y = den[o[k]].value;
+                    if(y <= 1) continue;
+                    if((double)target - (double)x / (double)y >= (double)distance) break;
+                    if(x % y == 0 && std::llabs(x / y - target) < distance){
+                        consider(best, have, target, Candidate{x / y, full, num_mask, i, o[k], '/'});
+                        distance = std::llabs(best.value - target);
+                    }
+                }
+                for(int k = start - 1; k >= 0; k--){
+                    long long y = den[o[k]].value;
+                    if(y <= 1) break;
+                    if((double)x / (double)y - (double)target >= (double)distance) break;
+                    if(x % y == 0 && std::llabs(x / y - target) < distance){
+                        consider(best, have, target, Candidate{x / y, full, num_mask, i, o[k], '/'});
+                        distance = std::llabs(best.value - target);
+                    }
+                }
+            }
+        }
+    }
+    //whether value is reachable from some subset; fills in the mask and expression of the result
+    bool find_exact(long long value, Result& result) const {
+        uint32_t full = (1u << numbers.size()) - 1;
+        uint32_t last = numbers.size() == 1 ? full : full - 1;
+        for(uint32_t mask = 1; mask <= last; mask++){
+            if(lookup(mask, value, result.expression)){
+                result.mask = mask;
+                return true;
+            }
+        }
+        bool found = false;
+        if(numbers.size() > 1){
+            reach::for_each_split(full, [&](uint32_t left, uint32_t right){
+                if(!found) found = probe_exact(left, right, value, result.expression);
+            });
+        }
+        if(found) result.mask = full;
+        return found;
+    }
+public:
+    //builds the tables for subsets of up to n-2 numbers; the n-1 subsets are built only
+    //if a closest (not exact) answer is needed, and the full set is only ever probed
+    explicit Solver(const std::vector<int>& arg1){
+        numbers.assign(arg1.begin(), arg1.end());
+        uint32_t full = (1u << numbers.size()) - 1;
+        tables.assign(full + 1, std::vector<Entry>());
+        index.assign(full + 1, std::vector<int>());
+        order.assign(full + 1, std::vector<int>());
+        for(size_t i = 0; i < numbers.size(); i++){
+            tables[1u << i].push_back(Entry{numbers[i], 0, 0, 0, 0});
+            index[1u << i].assign(2, -1);
+            index[1u << i][slot_of(numbers[i], 1)] = 0;
+        }
+        int eager = std::max(1, (int)numbers.size() - 2);
+        for(uint32_t mask = 1; mask < full; mask++)
+            if((mask & (mask - 1)) && __builtin_popcount(mask) <= eager) build_mask(mask);
+    }
+
+    size_t table_size(uint32_t mask) const { return tables[mask].size(); }
+
+    //exact or closest value to target from any subset. every value made is a positive whole
+    //number, so a target <= 0 has no answer: the result is empty (mask 0, no expression)
+    Result solve(long long target){
+        uint32_t full = (1u << numbers.size()) - 1;
+        Result result;
+        if(numbers.empty() || target <= 0) return result;
+        if(find_exact(target, result)){
+            result.exact = true;
+            result.value = target;
+            return result;
+        }
+        //the nearest value in the tables built so far bounds the distance; every ring
+        //closer than that is tried with exact probes, below first
+        uint32_t last = numbers.size() == 1 ? full : full - 1;
+        Candidate best{0, 0, 0, 0, 0, 0};
+        bool have = false;
+        for(uint32_t mask = 1; mask <= last; mask++)
+            for(int j = 0; built(mask) && j < (int)tables[mask].size(); j++)
+                consider(best, have, target, Candidate{tables[mask][j].value, mask, 0, j, -1, 0});
+        long long checked = 0;
+        for(; checked < RING_STEPS && std::llabs(best.value - target) > checked + 1; checked++){
+            long long below = target - checked - 1, above = target + checked + 1;
+            if(below > 0 && find_exact(below, result)){
+                result.value = below;
+                return result;
+            }
+            if(find_exact(above, result)){
+                result.value = above;
+                return result;
+            }
+        }
+        if(std::llabs(best.value - target) > checked + 1){
+            for(uint32_t mask = 1; mask < full; mask++)
+                if((mask & (mask - 1)) && !built(mask)) build_mask(mask);
+            for(uint32_t mask = 1; mask <= last; mask++)
+                near(mask, target, [&](int j){ consider(best, have, target, Candidate{tables[mask][j].value, mask, 0, j, -1, 0}); });
+            if(numbers.size() > 1){
+                reach::for_each_split(full, [&](uint32_t left, uint32_t right){
+                    probe_closest(full, left, right, target, checked + 1, best, have);
+                });
+            }
+        }
+        result.value = best.value;
+        result.mask = best.mask;
+        if(best.op == 0) result.expression = render(best.mask, best.left);
+        else result.expression = "(" + render(best.left_mask, best.left) + " " + best.op + " " + render(best.mask ^ best.left_mask, best.right) + ")";
+        return result;
+    }
+};
+
+}
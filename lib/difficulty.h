@@ -0,0 +1,117 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "hand_rank.h"
+#include "progress.h"
+#include "reachable.h"
+
+//per-(hand, target) difficulty scores. a hand is harder for a target when few of
+//its expressions reach it, and harder again when every one of those expressions
+//passes through a fraction (1 5 5 5 -> 24 is the classic case).
+//score 0 means unsolvable; solvable pairs score 1..255
+namespace difficulty{
+
+//expressions reaching a value, and how many of them keep every intermediate whole
+struct Ways{
+    uint64_t all = 0;
+    uint64_t whole = 0;
+};
+
+typedef std::unordered_map<Rational, Ways, RationalHash> WaysMap;
+
+inline void combine_ways(const WaysMap& left, const WaysMap& right, WaysMap& out){
+    for(WaysMap::const_iterator a = left.begin(); a != left.end(); ++a)
+        for(WaysMap::const_iterator b = right.begin(); b != right.end(); ++b)
+            reach::for_each_combination(a->first, b->first, [&](const Rational& r){
+                Ways& w = out[r];
+                w.all += a->second.all * b->second.all;
+                if(r.is_integer()) w.whole += a->second.whole * b->second.whole;
+            });
+}
+
+inline uint8_t score(uint64_t total, const Ways& ways){
+    if(ways.all == 0) return 0;
+    double rarity = std::log2((double)total / (double)ways.all);
+    int s = 1 + (int)(16 * rarity) + (ways.whole == 0 ? 48 : 0);
+    return (uint8_t)std::min(255, std::max(1, s));
+}
+
+//scores[t - lo] for every integer target t in [lo, hi]; like mark_integer_targets,
+//the full mask is never materialised, only its integer results are counted, and the
+//value pairs combined at the top level are returned
+inline uint64_t score_targets(const std::vector<int>& hand, long long lo, long long hi, uint8_t* scores){
+    std::vector<Rational> nums = reach::to_rationals(hand);
+    uint32_t full = (1u << nums.size()) - 1;
+    std::vector<Ways> counts((size_t)(hi - lo + 1));
+    uint64_t total = 0, pairs = 0;
+    if(nums.size() == 1){
+        total = 1;
+        pairs = 1;
+        if(hand[0] >= lo && hand[0] <= hi) counts[hand[0] - lo] = Ways{1, 1};
+    }
+    else{
+        std::vector<WaysMap> ways(full);
+        for(size_t i = 0; i < nums.size(); i++) ways[1u << i][nums[i]] = Ways{1, 1};
+        for(uint32_t mask = 1; mask < full; mask++)
+            if(mask & (mask - 1))
+                reach::for_each_split(mask, [&](uint32_t left, uint32_t right){ combine_ways(ways[left], ways[right], ways[mask]); });
+        reach::for_each_split(full, [&](uint32_t left, uint32_t right){
+            pairs += ways[left].size() * ways[right].size();
+            for(WaysMap::const_iterator a = ways[left].begin(); a != ways[left].end(); ++a)
+                for(WaysMap::const_iterator b = ways[right].begin(); b != ways[right].end(); ++b)
+                    reach::for_each_combination(a->first, b->first, [&](const Rational& r){
+                        uint64_t all = a->second.all * b->second.all;
+                        total += all;
+                        if(!r.is_integer() || r.num < lo || r.num > hi) return;
+                        Ways& w = counts[r.num - lo];
+                        w.all += all;
+                        w.whole += a->second.whole * b->second.whole;
+                    });
+        });
+    }
+    for(size_t t = 0; t < counts.size(); t++) scores[t] = score(total, counts[t]);
+    return pairs;
+}
+
+//scores for every hand of `cards` cards from 1..max_value against every target in range,
+//one byte per (hand rank, target)
+class DifficultyTable{
+private:
+    int cards;
+    int max_value;
+    long long min_target;
+    long long max_target;
+    uint64_t hands;
+    std::vector<uint8_t> scores;
+public:
+    DifficultyTable(int arg1, int arg2, long long arg3, long long arg4){
+        cards = arg1;
+        max_value = arg2;
+        min_target = arg3;
+        max_target = arg4;
+        hands = hand_count(cards, max_value);
+        scores.assign(hands * targets(), 0);
+    }
+    int get_cards() const { return cards; }
+    int get_max_value() const { return max_value; }
+    long long get_min_target() const { return min_target; }
+    long long get_max_target() const { return max_target; }
+    uint64_t get_hands() const { return hands; }
+    size_t targets() const { return (size_t)(max_target - min_target + 1); }
+
+    //each hand writes only its own scores, so threads split the ranks; see SolvableTable::build
+    void build(int threads = 1, ProgressBoard* progress = nullptr){
+        for_each_rank(hands, threads, progress, [this](uint64_t rank){
+            return score_targets(unrank_hand(rank, cards, max_value), min_target, max_target, scores.data() + rank * targets());
+        });
+    }
+    uint8_t get(uint64_t rank, long long target) const {
+        if(target < min_target || target > max_target) return 0;
+        return scores[rank * targets() + (target - min_target)];
+    }
+};
+
+}
@@ -0,0 +1,272 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "hand_rank.h"
+
+//precomputed tables compiled into the binary as read-only data, answering without any
+//build, file or decompression step. rows are stored packed: each hand keeps its row only
+//up to its last non-zero word (small hands reach few targets), and start[rank] gives where
+//it begins, so a lookup is one extra load and a compare. small tables (up to 3 cards) are
+//generated by the compiler from constexpr code; larger ones come from `gen-table`, which
+//writes them as a C++ source compiled into its own object (build with
+//SOLVE24_EMBEDDED_TABLES and link that object to get them)
+namespace embedded{
+
+//row[rank] is data[start[rank] .. start[rank + 1]); entries past a row's end are zero
+template<class T>
+struct PackedRows{
+    const uint32_t* start;
+    const T* data;
+
+    T get(uint64_t rank, uint64_t i) const {
+        uint64_t at = start[rank] + i;
+        return at < start[rank + 1] ? data[at] : 0;
+    }
+};
+
+//the solvability bits of SolvableTable, read-only
+struct SolvableView{
+    int cards;
+    int max_value;
+    long long min_target;
+    long long max_target;
+    uint64_t hands;
+    PackedRows<uint64_t> rows;
+
+    bool covers(const std::vector<int>& hand, long long target) const {
+        if((int)hand.size() != cards || target < min_target || target > max_target) return false;
+        for(size_t i = 0; i < hand.size(); i++)
+            if(hand[i] < 1 || hand[i] > max_value) return false;
+        return true;
+    }
+    bool is_solvable(uint64_t rank, long long target) const {
+        uint64_t off = (uint64_t)(target - min_target);
+        return (rows.get(rank, off >> 6) >> (off & 63)) & 1;
+    }
+    bool is_solvable(const std::vector<int>& hand, long long target) const {
+        return is_solvable(rank_hand(hand), target);
+    }
+    uint64_t get_hands() const { return hands; }
+    long long get_min_target() const { return min_target; }
+    long long get_max_target() const { return max_target; }
+    size_t get_bytes() const { return (hands + 1) * sizeof(uint32_t) + rows.start[hands] * sizeof(uint64_t); }
+};
+
+//the scores of difficulty::DifficultyTable, read-only; answers get() the same way
+struct DifficultyView{
+    int cards;
+    int max_value;
+    long long min_target;
+    long long max_target;
+    uint64_t hands;
+    PackedRows<uint8_t> rows;
+
+    uint8_t get(uint64_t rank, long long target) const {
+        if(target < min_target || target > max_target) return 0;
+        return rows.get(rank, (uint64_t)(target - min_target));
+    }
+    int get_cards() const { return cards; }
+    int get_max_value() const { return max_value; }
+    long long get_min_target() const { return min_target; }
+    long long get_max_target() const { return max_target; }
+    uint64_t get_hands() const { return hands; }
+    size_t get_bytes() const { return (hands + 1) * sizeof(uint32_t) + rows.start[hands]; }
+};
+
+template<class T>
+constexpr size_t packed_length(const T* row, size_t width){
+    while(width > 0 && row[width - 1] == 0) width--;
+    return width;
+}
+
+//exact arithmetic the compiler can run: the values of small hands stay far from overflow
+struct Fraction{
+    long long num;
+    long long den;
+};
+
+constexpr Fraction make_fraction(long long num, long long den){
+    if(den < 0){
+        num = -num;
+        den = -den;
+    }
+    long long a = num < 0 ? -num : num, b = den;
+    while(b != 0){
+        long long r = a % b;
+        a = b;
+        b = r;
+    }
+    return a > 1 ? Fraction{num / a, den / a} : Fraction{num, den};
+}
+
+const int MAX_CONSTEXPR_CARDS = 3;
+
+//sets the bit of every whole target in [min_target, max_target] the values can make
+constexpr void mark_targets(const Fraction* values, int n, long long min_target, long long max_target, uint64_t* row){
+    if(n == 1){
+        const Fraction& v = values[0];
+        if(v.den == 1 && v.num >= min_target && v.num <= max_target){
+            uint64_t off = (uint64_t)(v.num - min_target);
+            row[off >> 6] |= (uint64_t)1 << (off & 63);
+        }
+        return;
+    }
+    for(int i = 0; i + 1 < n; i++){
+        for(int j = i + 1; j < n; j++){
+            Fraction next[MAX_CONSTEXPR_CARDS] = {};
+            int m = 0;
+            for(int k = 0; k < n; k++)
+                if(k != i && k != j) next[m++] = values[k];
+            const Fraction a = values[i], b = values[j];
+            for(int op = 0; op < 6; op++){
+                if((op == 3 && b.num == 0) || (op == 5 && a.num == 0)) continue;
+                switch(op){
+                    case 0: next[m] = make_fraction(a.num * b.den + b.num * a.den, a.den * b.den); break;
+                    case 1: next[m] = make_fraction(a.num * b.num, a.den * b.den); break;
+                    case 2: next[m] = make_fraction(a.num * b.den - b.num * a.den, a.den * b.den); break;
+                    case 3: next[m] = make_fraction(a.num * b.den, a.den * b.num); break;
+                    case 4: next[m] = make_fraction(b.num * a.den - a.num * b.den, a.den * b.den); break;
+                    default: next[m] = make_fraction(b.num * a.den, b.den * a.num); break;
+                }
+                mark_targets(next, m + 1, min_target, max_target, row);
+            }
+        }
+    }
+}
+
+template<size_t Hands, size_t Words>
+struct PackedStorage{
+    uint32_t start[Hands + 1];
+    uint64_t data[Words > 0 ? Words : 1];
+};
+
+//SolvableTable(Cards, MaxValue, MinTarget, MaxTarget) evaluated at compile time, with the
+//same ranks and bits, packed; view is usable in constant expressions
+template<int Cards, int MaxValue, long long MinTarget, long long MaxTarget>
+struct SmallSolvable{
+    static_assert(Cards >= 1 && Cards <= MAX_CONSTEXPR_CARDS && MaxValue >= 1 && MaxValue <= 100 && MinTarget <= MaxTarget,
+                  "constexpr tables are for small hands; use gen-table for the rest");
+    static constexpr uint64_t HANDS = hand_count(Cards, MaxValue);
+    static constexpr size_t WIDTH = (size_t)((MaxTarget - MinTarget) / 64 + 1);
+
+    static constexpr std::array<uint64_t, HANDS * WIDTH> build_dense(){
+        std::array<uint64_t, HANDS * WIDTH> bits{};
+        //hands in rank order: colex over sorted hands, as unrank_hand gives them
+        int hand[Cards] = {};
+        for(uint64_t rank = 0; rank < HANDS; rank++){
+            uint64_t left = rank;
+            int top = MaxValue + Cards - 2;
+            for(int i = Cards - 1; i >= 0; i--){
+                while(binomial(top, i + 1) > left) top--;
+                left -= binomial(top, i + 1);
+                hand[i] = top - i + 1;
+                top--;
+            }
+            Fraction values[MAX_CONSTEXPR_CARDS] = {};
+            for(int i = 0; i < Cards; i++) values[i] = Fraction{hand[i], 1};
+            mark_targets(values, Cards, MinTarget, MaxTarget, &bits[rank * WIDTH]);
+        }
+        return bits;
+    }
+    static constexpr std::array<uint64_t, HANDS * WIDTH> DENSE = build_dense();
+
+    static constexpr size_t packed_words(){
+        size_t words = 0;
+        for(uint64_t rank = 0; rank < HANDS; rank++) words += packed_length(&DENSE[rank * WIDTH], WIDTH);
+        return words;
+    }
+    static constexpr size_t WORDS = packed_words();
+
+    static constexpr PackedStorage<HANDS, WORDS> pack(){
+        PackedStorage<HANDS, WORDS> packed{};
+        uint32_t at = 0;
+        for(uint64_t rank = 0; rank < HANDS; rank++){
+            packed.start[rank] = at;
+            size_t length = packed_length(&DENSE[rank * WIDTH], WIDTH);
+            for(size_t i = 0; i < length; i++) packed.data[at++] = DENSE[rank * WIDTH + i];
+        }
+        packed.start[HANDS] = at;
+        return packed;
+    }
+    static constexpr PackedStorage<HANDS, WORDS> PACKED = pack();
+    static constexpr SolvableView view = {Cards, MaxValue, MinTarget, MaxTarget, HANDS, {PACKED.start, PACKED.data}};
+};
+
+#ifdef SOLVE24_EMBEDDED_TABLES
+//defined in the source gen-table writes
+extern const SolvableView generated_solvable;
+extern const DifficultyView generated_difficulty;
+#endif
+
+//an embedded table with these cards and values whose targets include [min_target, max_target],
+//or nullptr when the binary has none
+inline const SolvableView* find_solvable(int cards, int max_value, long long min_target, long long max_target){
+    const SolvableView* tables[] = {
+        &SmallSolvable<2, 13, 0, 1000>::view,
+        &SmallSolvable<3, 13, 0, 1000>::view,
+#ifdef SOLVE24_EMBEDDED_TABLES
+        &generated_solvable,
+#endif
+    };
+    for(size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++){
+        const SolvableView* t = tables[i];
+        if(t->cards == cards && t->max_value == max_value && t->min_target <= min_target && t->max_target >= max_target) return t;
+    }
+    return nullptr;
+}
+inline const DifficultyView* find_difficulty(int cards, int max_value, long long min_target, long long max_target){
+#ifdef SOLVE24_EMBEDDED_TABLES
+    const DifficultyView* t = &generated_difficulty;
+    if(t->cards == cards && t->max_value == max_value && t->min_target <= min_target && t->max_target >= max_target) return t;
+#endif
+    return nullptr;
+}
+
+//writes "name_start" and "name_data", the packed rows row(rank) (width entries each), to
+//out as C++ initialisers
+template<class T, class Row>
+inline bool write_packed(FILE* out, const char* name, const char* type, uint64_t hands, size_t width, Row row){
+    std::vector<uint32_t> start(1, 0);
+    std::vector<T> data;
+    for(uint64_t rank = 0; rank < hands; rank++){
+        std::vector<T> entries = row(rank);
+        data.insert(data.end(), entries.begin(), entries.begin() + packed_length(entries.data(), width));
+        start.push_back((uint32_t)data.size());
+    }
+    bool ok = std::fprintf(out, "alignas(64) const uint32_t %s_start[] = {", name) > 0;
+    for(size_t i = 0; i < start.size() && ok; i++) ok = std::fprintf(out, "%s%u", i == 0 ? "\n" : i % 16 ? "," : ",\n", start[i]) > 0;
+    ok = ok && std::fprintf(out, "\n};\nalignas(64) const %s %s_data[] = {", type, name) > 0;
+    for(size_t i = 0; i < data.size() && ok; i++) ok = std::fprintf(out, "%s0x%llx", i == 0 ? "\n" : i % 12 ? "," : ",\n", (unsigned long long)data[i]) > 0;
+    if(data.empty()) ok = ok && std::fprintf(out, "0") > 0;
+    return ok && std::fprintf(out, "\n};\n") > 0;
+}
+
+//the source defining generated_solvable and generated_difficulty from a built SolvableTable
+//and difficulty::DifficultyTable; command goes in its header line
+template<class Solvable, class Difficulty>
+inline bool write_source(const std::string& path, const std::string& command, const Solvable& solvable, const Difficulty& difficulty){
+    FILE* out = std::fopen(path.c_str(), "wb");
+    if(!out) return false;
+    size_t words = solvable.get_words_per_hand();
+    size_t targets = difficulty.targets();
+    bool ok = std::fprintf(out, "//generated by `%s`; do not edit\n#include \"embedded_table.h\"\n\nnamespace embedded{\n\nnamespace{\n", command.c_str()) > 0
+           && write_packed<uint64_t>(out, "solvable", "uint64_t", solvable.get_hands(), words, [&](uint64_t rank){
+                  return std::vector<uint64_t>(solvable.hand_bits(rank), solvable.hand_bits(rank) + words);
+              })
+           && write_packed<uint8_t>(out, "difficulty", "uint8_t", difficulty.get_hands(), targets, [&](uint64_t rank){
+                  std::vector<uint8_t> row(targets);
+                  for(size_t t = 0; t < targets; t++) row[t] = difficulty.get(rank, difficulty.get_min_target() + (long long)t);
+                  return row;
+              })
+           && std::fprintf(out, "}\n\nextern const SolvableView generated_solvable = {%d, %d, %lld, %lld, %lluULL, {solvable_start, solvable_data}};\n",
+                           solvable.get_cards(), solvable.get_max_value(), solvable.get_min_target(), solvable.get_max_target(),
+                           (unsigned long long)solvable.get_hands()) > 0
+           && std::fprintf(out, "extern const DifficultyView generated_difficulty = {%d, %d, %lld, %lld, %lluULL, {difficulty_start, difficulty_data}};\n\n}\n",
+                           difficulty.get_cards(), difficulty.get_max_value(), difficulty.get_min_target(), difficulty.get_max_target(),
+                           (unsigned long long)difficulty.get_hands()) > 0;
+    return std::fclose(out) == 0 && ok;
+}
+}
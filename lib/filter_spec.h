@@ -0,0 +1,64 @@
+#pragma once
+#include <string>
+
+//constraints on which solutions count, pushed into the search rather than applied to
+//its output: forbidden operators are never expanded, fractional or negative
+//intermediates are dropped where they are made, and required operators are tracked
+//as a bitmask so a branch is cut once too few steps remain to use the missing ones.
+//operator bits are Solver's: + 1, - 2, * 4, / 8
+struct FilterSpec{
+    unsigned ops = 15;
+    unsigned required = 0;
+    bool whole = false;
+    bool non_negative = false;
+
+    bool is_default() const { return ops == 15 && required == 0 && !whole && !non_negative; }
+    //distinguishes specs in cache keys; 0 for the default
+    unsigned tag() const { return is_default() ? 0 : 1024 | ops << 4 | required | (whole ? 256 : 0) | (non_negative ? 512 : 0); }
+};
+
+inline unsigned op_bit(char op){
+    switch(op){
+        case '+': return 1;
+        case '-': return 2;
+        case '*': case 'x': return 4;
+        case '/': return 8;
+    }
+    return 0;
+}
+
+inline bool parse_op_list(const std::string& text, unsigned& bits){
+    bits = 0;
+    for(size_t i = 0; i < text.size(); i++){
+        if(!op_bit(text[i])) return false;
+        bits |= op_bit(text[i]);
+    }
+    return true;
+}
+
+inline std::string format_op_list(unsigned bits){
+    std::string text;
+    const char symbols[] = "+-*/";
+    for(int i = 0; i < 4; i++) if(bits & (1u << i)) text.push_back(symbols[i]);
+    return text;
+}
+
+//one request token: "ops=+*", "must=/", "whole" or "nonneg"
+inline bool parse_filter_token(const std::string& token, FilterSpec& spec){
+    if(token == "whole") spec.whole = true;
+    else if(token == "nonneg") spec.non_negative = true;
+    else if(token.compare(0, 4, "ops=") == 0) return parse_op_list(token.substr(4), spec.ops) && spec.ops != 0;
+    else if(token.compare(0, 5, "must=") == 0) return parse_op_list(token.substr(5), spec.required);
+    else return false;
+    return true;
+}
+
+//the tokens parse_filter_token reads back, space separated; empty for the default
+inline std::string format_filter(const FilterSpec& spec){
+    std::string text;
+    if(spec.ops != 15) text += " ops=" + format_op_list(spec.ops);
+    if(spec.required) text += " must=" + format_op_list(spec.required);
+    if(spec.whole) text += " whole";
+    if(spec.non_negative) text += " nonneg";
+    return text.empty() ? text : text.substr(1);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+//ranks a hand (multiset of n cards from 1..max_value) into [0, hand_count(n, max_value))
+//sorted c1 <= c2 <= ... <= cn maps to the strictly increasing c_i + i, which is ranked
+//with the combinatorial number system, so ranks follow colex order of sorted hands
+
+constexpr uint64_t binomial(int n, int k){
+    if(k < 0 || n < 0 || k > n) return 0;
+    if(k > n - k) k = n - k;
+    uint64_t result = 1;
+    for(int i = 1; i <= k; i++)
+        result = result * (uint64_t)(n - k + i) / (uint64_t)i;
+    return result;
+}
+
+constexpr uint64_t hand_count(int cards, int max_value){
+    return binomial(max_value + cards - 1, cards);
+}
+
+inline uint64_t rank_hand(std::vector<int> hand){
+    std::sort(hand.begin(), hand.end());
+    uint64_t rank = 0;
+    for(int i = 0; i < (int)hand.size(); i++)
+        rank += binomial(hand[i] - 1 + i, i + 1);
+    return rank;
+}
+
+inline std::vector<int> unrank_hand(uint64_t rank, int cards, int max_value){
+    std::vector<int> hand(cards);
+    int top = max_value + cards - 2;
+    for(int i = cards - 1; i >= 0; i--){
+        while(binomial(top, i + 1) > rank) top--;
+        rank -= binomial(top, i + 1);
+        hand[i] = top - i + 1;
+        top--;
+    }
+    return hand;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "target_index.h"
+
+//draws solvable hands for one target from difficulty bands. every band holds an
+//alias table (walker/vose) over its hands, so a draw costs one random number, one
+//table lookup and one compare: no rejection, whatever the weights. the generator is
+//xoshiro256** seeded through splitmix64, so a seed gives the same stream everywhere
+
+//xoshiro256**
+class SampleRng{
+private:
+    uint64_t s[4];
+    static uint64_t rotl(uint64_t x, int k){ return (x << k) | (x >> (64 - k)); }
+public:
+    explicit SampleRng(uint64_t seed){
+        for(int i = 0; i < 4; i++){
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            s[i] = z ^ (z >> 31);
+        }
+    }
+    uint64_t next(){
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+};
+
+//column i keeps itself with probability keep[i] / 2^32, otherwise it yields alias[i]
+class AliasTable{
+private:
+    std::vector<uint32_t> keep;
+    std::vector<uint32_t> alias;
+public:
+    //false when there is nothing to draw (no weights, or none positive)
+    bool build(const std::vector<double>& weights){
+        size_t n = weights.size();
+        keep.assign(n, 0);
+        alias.assign(n, 0);
+        double total = 0;
+        for(size_t i = 0; i < n; i++) total += weights[i] > 0 ? weights[i] : 0;
+        if(n == 0 || total <= 0){
+            keep.clear();
+            alias.clear();
+            return false;
+        }
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small, large;
+        for(size_t i = 0; i < n; i++){
+            scaled[i] = (weights[i] > 0 ? weights[i] : 0) * n / total;
+            (scaled[i] < 1 ? small : large).push_back((uint32_t)i);
+        }
+        while(!small.empty() && !large.empty()){
+            uint32_t s = small.back(), l = large.back();
+            small.pop_back();
+            keep[s] = (uint32_t)(scaled[s] * 4294967296.0);
+            alias[s] = l;
+            scaled[l] -= 1 - scaled[s];
+            if(scaled[l] < 1){
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        //whatever is left is 1 up to rounding and always keeps itself
+        for(size_t i = 0; i < large.size(); i++){ keep[large[i]] = UINT32_MAX; alias[large[i]] = large[i]; }
+        for(size_t i = 0; i < small.size(); i++){ keep[small[i]] = UINT32_MAX; alias[small[i]] = small[i]; }
+        return true;
+    }
+    size_t size() const { return keep.size(); }
+    //high half picks the column (multiply-shift, no modulo), low half flips its coin
+    uint32_t sample(uint64_t random) const {
+        uint32_t column = (uint32_t)(((random >> 32) * (uint64_t)keep.size()) >> 32);
+        return (uint32_t)random < keep[column] ? column : alias[column];
+    }
+};
+
+struct DifficultyBand{
+    int min_difficulty;
+    int max_difficulty;
+};
+
+//weight of a hand by its difficulty within its band
+typedef std::function<double(int difficulty, const DifficultyBand& band)> BandWeight;
+
+inline double uniform_weight(int, const DifficultyBand&){ return 1; }
+
+//triangular, peaking at the middle of the band: moderate hands come up most often
+inline double centered_weight(int difficulty, const DifficultyBand& band){
+    double middle = (band.min_difficulty + band.max_difficulty) / 2.0;
+    double half = (band.max_difficulty - band.min_difficulty) / 2.0 + 1;
+    double distance = difficulty > middle ? difficulty - middle : middle - difficulty;
+    return half - distance;
+}
+
+class HandSampler{
+private:
+    std::vector<DifficultyBand> bands;
+    std::vector<std::vector<Posting>> hands;
+    std::vector<AliasTable> tables;
+public:
+    //one alias table per band over the hands that make target; a band with no hands stays empty
+    HandSampler(const TargetIndex& index, long long target, const std::vector<DifficultyBand>& arg3,
+                const BandWeight& weight = uniform_weight){
+        bands = arg3;
+        hands.resize(bands.size());
+        tables.resize(bands.size());
+        for(size_t b = 0; b < bands.size(); b++){
+            hands[b] = index.hands_for(target, index.count(target), bands[b].min_difficulty, bands[b].max_difficulty);
+            std::vector<double> weights(hands[b].size());
+            for(size_t i = 0; i < weights.size(); i++) weights[i] = weight(hands[b][i].difficulty, bands[b]);
+            tables[b].build(weights);
+        }
+    }
+    size_t band_count() const { return bands.size(); }
+    const DifficultyBand& get_band(size_t band) const { return bands[band]; }
+    size_t band_size(size_t band) const { return tables[band].size(); }
+
+    //false when the band has no hands
+    bool sample(size_t band, SampleRng& rng, Posting& out) const {
+        if(band >= tables.size() || tables[band].size() == 0) return false;
+        out = hands[band][tables[band].sample(rng.next())];
+        return true;
+    }
+};
@@ -0,0 +1,214 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#endif
+
+//backing memory for the large lookup tables and caches. random probes into
+//multi-megabyte tables are dominated by TLB misses on 4k pages, so on linux we
+//try explicit 2M pages (MAP_HUGETLB, needs vm.nr_hugepages), then transparent
+//huge pages (madvise), then plain pages. other platforms get plain memory
+enum class HugePageMode { off, transparent, explicit_pages };
+
+inline const char* huge_page_mode_name(HugePageMode mode){
+    switch(mode){
+        case HugePageMode::explicit_pages: return "explicit";
+        case HugePageMode::transparent: return "thp";
+        default: return "off";
+    }
+}
+
+inline bool parse_huge_page_mode(const std::string& name, HugePageMode& mode){
+    if(name == "off") mode = HugePageMode::off;
+    else if(name == "thp") mode = HugePageMode::transparent;
+    else if(name == "explicit") mode = HugePageMode::explicit_pages;
+    else return false;
+    return true;
+}
+
+//process-wide defaults, set once from the command line before tables are built
+struct HugePageSettings{
+    HugePageMode mode = HugePageMode::transparent;
+    bool prefault = false;
+};
+inline HugePageSettings& huge_page_settings(){
+    static HugePageSettings settings;
+    return settings;
+}
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+inline size_t round_up(size_t bytes, size_t align){
+    return (bytes + align - 1) / align * align;
+}
+
+//touches one byte per 4k page so every page is mapped before the first lookup
+inline void prefault_pages(void* ptr, size_t bytes){
+    volatile char* p = (volatile char*)ptr;
+    for(size_t off = 0; off < bytes; off += 4096)
+        p[off] = p[off];
+}
+
+//owns one zero-initialised region; mode() reports what was actually obtained
+class HugePageRegion{
+private:
+    void* ptr;
+    size_t bytes;
+    HugePageMode got;
+public:
+    HugePageRegion() : ptr(nullptr), bytes(0), got(HugePageMode::off) {}
+    HugePageRegion(size_t size, HugePageMode requested, bool prefault) : HugePageRegion() {
+        allocate(size, requested, prefault);
+    }
+    ~HugePageRegion(){ release(); }
+    HugePageRegion(const HugePageRegion&) = delete;
+    HugePageRegion& operator=(const HugePageRegion&) = delete;
+    HugePageRegion(HugePageRegion&& other) noexcept : ptr(other.ptr), bytes(other.bytes), got(other.got) {
+        other.ptr = nullptr;
+        other.bytes = 0;
+    }
+    HugePageRegion& operator=(HugePageRegion&& other) noexcept {
+        if(this != &other){
+            release();
+            ptr = other.ptr; bytes = other.bytes; got = other.got;
+            other.ptr = nullptr; other.bytes = 0;
+        }
+        return *this;
+    }
+
+    void* data() const { return ptr; }
+    size_t size() const { return bytes; }
+    HugePageMode mode() const { return got; }
+
+    void allocate(size_t size, HugePageMode requested, bool prefault){
+        release();
+        if(size == 0) return;
+#ifdef __linux__
+        if(size >= HUGE_PAGE_SIZE / 2 && requested != HugePageMode::off){
+            size_t rounded = round_up(size, HUGE_PAGE_SIZE);
+            if(requested == HugePageMode::explicit_pages){
+                void* p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (prefault ? MAP_POPULATE : 0), -1, 0);
+                if(p != MAP_FAILED){
+                    ptr = p; bytes = rounded; got = HugePageMode::explicit_pages;
+                    return;
+                }
+            }
+            //over-allocate so the region can start on a 2M boundary, which khugepaged needs
+            size_t mapped = rounded + HUGE_PAGE_SIZE;
+            void* p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(p != MAP_FAILED){
+                uintptr_t start = round_up((uintptr_t)p, HUGE_PAGE_SIZE);
+                size_t head = start - (uintptr_t)p;
+                if(head > 0) munmap(p, head);
+                if(mapped - head > rounded) munmap((char*)start + rounded, mapped - head - rounded);
+                ptr = (void*)start; bytes = rounded;
+                got = madvise(ptr, rounded, MADV_HUGEPAGE) == 0 ? HugePageMode::transparent : HugePageMode::off;
+                if(prefault) prefault_pages(ptr, bytes);
+                return;
+            }
+        }
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p == MAP_FAILED) throw std::bad_alloc();
+        ptr = p; bytes = size; got = HugePageMode::off;
+#else
+        (void)requested;
+        ptr = std::calloc(1, size);
+        if(!ptr) throw std::bad_alloc();
+        bytes = size; got = HugePageMode::off;
+#endif
+        if(prefault) prefault_pages(ptr, bytes);
+    }
+
+    void release(){
+        if(!ptr) return;
+#ifdef __linux__
+        munmap(ptr, bytes);
+#else
+        std::free(ptr);
+#endif
+        ptr = nullptr;
+        bytes = 0;
+    }
+};
+
+//fixed-length array of trivially copyable T on top of a HugePageRegion
+template<class T>
+class HugePageArray{
+private:
+    HugePageRegion region;
+    size_t count;
+public:
+    HugePageArray() : count(0) {}
+    explicit HugePageArray(size_t n) : count(0) { resize(n); }
+
+    void resize(size_t n){
+        const HugePageSettings& settings = huge_page_settings();
+        region.allocate(n * sizeof(T), settings.mode, settings.prefault);
+        count = n;
+    }
+    T* data() const { return (T*)region.data(); }
+    size_t size() const { return count; }
+    size_t bytes() const { return count * sizeof(T); }
+    HugePageMode mode() const { return region.mode(); }
+    T& operator[](size_t i){ return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+};
+
+//counts data TLB read misses of the calling thread through perf_event_open
+//available() is false when perf events are unsupported or not permitted
+class TlbMissCounter{
+private:
+    int fd;
+public:
+    TlbMissCounter() : fd(-1) {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~TlbMissCounter(){
+#ifdef __linux__
+        if(fd >= 0) close(fd);
+#endif
+    }
+    TlbMissCounter(const TlbMissCounter&) = delete;
+    TlbMissCounter& operator=(const TlbMissCounter&) = delete;
+
+    bool available() const { return fd >= 0; }
+    void start(){
+#ifdef __linux__
+        if(fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    //returns the misses since start(), or -1 when unavailable
+    long long stop(){
+#ifdef __linux__
+        if(fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if(read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) return -1;
+        return count;
+#else
+        return -1;
+#endif
+    }
+};
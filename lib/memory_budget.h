@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//per-query memory accounting. stored solutions and search scratch (the
+//per-frame value and step vectors) are charged against an optional cap;
+//an attached shared cache is reported but not charged, since it outlives
+//the query and belongs to whoever created it
+enum class OverflowPolicy { truncate, count_only, spill };
+enum class DegradeReason { none, max_generated, memory_cap };
+
+inline const char* degrade_reason_name(DegradeReason reason){
+    switch(reason){
+        case DegradeReason::max_generated: return "max_generated";
+        case DegradeReason::memory_cap: return "memory cap";
+        default: return "none";
+    }
+}
+
+//result metadata of the last query on a Solution
+struct QueryStats{
+    size_t high_water_bytes = 0;
+    size_t solution_bytes = 0;
+    size_t cache_bytes = 0;
+    size_t cap_bytes = 0;
+    bool truncated = false;
+    bool count_only = false;
+    DegradeReason reason = DegradeReason::none;
+    long long solution_count = 0;
+    unsigned long long nodes = 0;
+    bool spilled = false;
+    //a run or the merged file could not be written: spill_path is not a result then, and
+    //spilled_solutions is 0
+    bool spill_failed = false;
+    long long spilled_solutions = 0;
+    std::string spill_path;
+};
+
+class MemoryBudget{
+private:
+    size_t cap;
+    size_t used;
+    size_t high_water;
+public:
+    MemoryBudget() : cap(0), used(0), high_water(0) {}
+
+    void set_cap(size_t bytes){ cap = bytes; }
+    size_t get_cap() const { return cap; }
+    size_t get_used() const { return used; }
+    size_t get_high_water() const { return high_water; }
+    void reset(){ used = 0; high_water = 0; }
+
+    //charges bytes unless that would pass the cap; cap 0 means unlimited
+    bool charge(size_t bytes){
+        if(cap != 0 && used + bytes > cap) return false;
+        force(bytes);
+        return true;
+    }
+    //charges regardless of the cap, for memory the search cannot do without
+    void force(size_t bytes){
+        used += bytes;
+        if(used > high_water) high_water = used;
+    }
+    void release(size_t bytes){
+        used = bytes > used ? 0 : used - bytes;
+    }
+};
+
+inline size_t string_bytes(const std::string& s){
+    //short strings live inside the object (libstdc++ and msvc keep up to 15 chars inline)
+    return sizeof(std::string) + (s.capacity() > 15 ? s.capacity() + 1 : 0);
+}
+
+inline size_t steps_bytes(const std::vector<std::string>& steps){
+    size_t bytes = sizeof(steps) + (steps.capacity() - steps.size()) * sizeof(std::string);
+    for(size_t i = 0; i < steps.size(); i++) bytes += string_bytes(steps[i]);
+    return bytes;
+}
+
+//charges one search frame for as long as it is alive
+class ScratchCharge{
+private:
+    MemoryBudget& budget;
+    size_t bytes;
+public:
+    ScratchCharge(MemoryBudget& arg1, size_t arg2) : budget(arg1), bytes(arg2) { budget.force(bytes); }
+    ~ScratchCharge(){ budget.release(bytes); }
+    ScratchCharge(const ScratchCharge&) = delete;
+    ScratchCharge& operator=(const ScratchCharge&) = delete;
+};
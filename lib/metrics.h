@@ -0,0 +1,276 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+//solver health counters and latency histograms. every thread records into its
+//own cache-line aligned shard with plain relaxed load/store (one writer per
+//shard, so no atomic read-modify-write on the hot path); exposition sums the
+//shards. shards are never freed, so counts survive thread exit
+enum class SolveMode { exists, first, all, count, best };
+const int SOLVE_MODE_COUNT = 5;
+
+inline const char* solve_mode_name(SolveMode mode){
+    switch(mode){
+        case SolveMode::exists: return "exists";
+        case SolveMode::first: return "first";
+        case SolveMode::all: return "all";
+        case SolveMode::best: return "best";
+        default: return "count";
+    }
+}
+
+enum class Counter { nodes, cache_hits, cache_misses, truncations, solutions, COUNT };
+const int COUNTER_COUNT = (int)Counter::COUNT;
+
+//log-linear buckets in the spirit of HdrHistogram: 16 sub-buckets per power
+//of two of nanoseconds, so any recorded latency is within 1/16 of its bucket
+const int HISTOGRAM_SUB_BITS = 4;
+const int HISTOGRAM_SUB = 1 << HISTOGRAM_SUB_BITS;
+const int HISTOGRAM_BUCKETS = (64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB;
+//the exposition's fixed buckets, the same in every scrape: each power of two of nanoseconds
+//from 2^10 (about 1 us) to 2^36 (about 69 s). powers of two are bucket edges, so they are exact
+const int EXPOSITION_FIRST_POWER = 10;
+const int EXPOSITION_LAST_POWER = 36;
+
+inline int histogram_bucket(uint64_t ns){
+    if(ns < (uint64_t)HISTOGRAM_SUB) return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - HISTOGRAM_SUB_BITS;
+    return (shift + 1) * HISTOGRAM_SUB + (int)((ns >> shift) & (HISTOGRAM_SUB - 1));
+}
+
+//largest value that still falls in bucket
+inline uint64_t histogram_bucket_limit(int bucket){
+    if(bucket < HISTOGRAM_SUB) return (uint64_t)bucket;
+    int shift = bucket / HISTOGRAM_SUB - 1;
+    uint64_t base = (uint64_t)(HISTOGRAM_SUB + bucket % HISTOGRAM_SUB) << shift;
+    return base + ((1ULL << shift) - 1);
+}
+
+//value at quantile q (0..1) of a bucket-count vector, as the upper bound of its bucket
+inline uint64_t histogram_quantile(const std::vector<uint64_t>& buckets, double q){
+    uint64_t total = 0;
+    for(size_t b = 0; b < buckets.size(); b++) total += buckets[b];
+    if(total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (double)(total - 1)) + 1, seen = 0;
+    for(size_t b = 0; b < buckets.size(); b++){
+        seen += buckets[b];
+        if(seen >= rank) return histogram_bucket_limit((int)b);
+    }
+    return histogram_bucket_limit(HISTOGRAM_BUCKETS - 1);
+}
+
+inline void bump(std::atomic<uint64_t>& cell, uint64_t by){
+    cell.store(cell.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+struct alignas(64) MetricsShard{
+    std::atomic<uint64_t> requests[SOLVE_MODE_COUNT];
+    std::atomic<uint64_t> latency_sum[SOLVE_MODE_COUNT];
+    std::atomic<uint64_t> counters[COUNTER_COUNT];
+    std::atomic<uint64_t> latency[SOLVE_MODE_COUNT][HISTOGRAM_BUCKETS];
+
+    MetricsShard(){
+        for(int m = 0; m < SOLVE_MODE_COUNT; m++){
+            requests[m].store(0, std::memory_order_relaxed);
+            latency_sum[m].store(0, std::memory_order_relaxed);
+            for(int b = 0; b < HISTOGRAM_BUCKETS; b++) latency[m][b].store(0, std::memory_order_relaxed);
+        }
+        for(int c = 0; c < COUNTER_COUNT; c++) counters[c].store(0, std::memory_order_relaxed);
+    }
+};
+
+//point-in-time sum over all shards
+struct MetricsSnapshot{
+    uint64_t requests[SOLVE_MODE_COUNT] = {};
+    uint64_t latency_sum[SOLVE_MODE_COUNT] = {};
+    uint64_t counters[COUNTER_COUNT] = {};
+    std::vector<uint64_t> latency[SOLVE_MODE_COUNT];
+
+    //latency in ns at quantile q (0..1) for mode, upper bound of the bucket
+    uint64_t quantile(SolveMode mode, double q) const {
+        return histogram_quantile(latency[(int)mode], q);
+    }
+};
+
+class MetricsRegistry{
+private:
+    std::mutex shards_lock;
+    std::vector<MetricsShard*> shards;
+    std::atomic<bool> serving;
+    std::thread server;
+    int server_fd;
+    std::string socket_path;
+public:
+    MetricsRegistry() : serving(false), server_fd(-1) {}
+    ~MetricsRegistry(){
+        stop_socket();
+        for(size_t i = 0; i < shards.size(); i++) delete shards[i];
+    }
+
+    //the calling thread's shard, registered on first use
+    MetricsShard& local(){
+        thread_local MetricsShard* shard = nullptr;
+        thread_local MetricsRegistry* owner = nullptr;
+        if(shard == nullptr || owner != this){
+            shard = new MetricsShard();
+            owner = this;
+            std::lock_guard<std::mutex> guard(shards_lock);
+            shards.push_back(shard);
+        }
+        return *shard;
+    }
+
+    void record_request(SolveMode mode, uint64_t ns){
+        MetricsShard& shard = local();
+        bump(shard.requests[(int)mode], 1);
+        bump(shard.latency_sum[(int)mode], ns);
+        bump(shard.latency[(int)mode][histogram_bucket(ns)], 1);
+    }
+    void add(Counter counter, uint64_t by){
+        if(by != 0) bump(local().counters[(int)counter], by);
+    }
+
+    MetricsSnapshot snapshot(){
+        MetricsSnapshot snap;
+        for(int m = 0; m < SOLVE_MODE_COUNT; m++) snap.latency[m].assign(HISTOGRAM_BUCKETS, 0);
+        std::lock_guard<std::mutex> guard(shards_lock);
+        for(size_t i = 0; i < shards.size(); i++){
+            MetricsShard& shard = *shards[i];
+            for(int m = 0; m < SOLVE_MODE_COUNT; m++){
+                snap.requests[m] += shard.requests[m].load(std::memory_order_relaxed);
+                snap.latency_sum[m] += shard.latency_sum[m].load(std::memory_order_relaxed);
+                for(int b = 0; b < HISTOGRAM_BUCKETS; b++)
+                    snap.latency[m][b] += shard.latency[m][b].load(std::memory_order_relaxed);
+            }
+            for(int c = 0; c < COUNTER_COUNT; c++)
+                snap.counters[c] += shard.counters[c].load(std::memory_order_relaxed);
+        }
+        return snap;
+    }
+
+    //prometheus text exposition format 0.0.4
+    std::string exposition(){
+        MetricsSnapshot snap = snapshot();
+        std::ostringstream out;
+        out << "# HELP solve24_requests_total Solver queries by mode.\n# TYPE solve24_requests_total counter\n";
+        for(int m = 0; m < SOLVE_MODE_COUNT; m++)
+            out << "solve24_requests_total{mode=\"" << solve_mode_name((SolveMode)m) << "\"} " << snap.requests[m] << "\n";
+        const char* names[COUNTER_COUNT] = {"solve24_nodes_searched_total", "solve24_cache_hits_total",
+                                            "solve24_cache_misses_total", "solve24_truncations_total",
+                                            "solve24_solutions_total"};
+        const char* help[COUNTER_COUNT] = {"Search nodes expanded.", "Transposition cache hits.",
+                                           "Transposition cache misses.", "Queries that hit max_generated.",
+                                           "Solutions produced."};
+        for(int c = 0; c < COUNTER_COUNT; c++){
+            out << "# HELP " << names[c] << " " << help[c] << "\n# TYPE " << names[c] << " counter\n";
+            out << names[c] << " " << snap.counters[c] << "\n";
+        }
+        uint64_t hits = snap.counters[(int)Counter::cache_hits];
+        uint64_t lookups = hits + snap.counters[(int)Counter::cache_misses];
+        out << "# HELP solve24_cache_hit_ratio Transposition cache hit ratio.\n# TYPE solve24_cache_hit_ratio gauge\n";
+        out << "solve24_cache_hit_ratio " << (lookups ? (double)hits / (double)lookups : 0.0) << "\n";
+        out << "# HELP solve24_request_duration_seconds Solver query latency.\n# TYPE solve24_request_duration_seconds histogram\n";
+        for(int m = 0; m < SOLVE_MODE_COUNT; m++){
+            const char* mode = solve_mode_name((SolveMode)m);
+            uint64_t cumulative = 0;
+            int b = 0;
+            for(int power = EXPOSITION_FIRST_POWER; power <= EXPOSITION_LAST_POWER; power++){
+                for(int edge = histogram_bucket(1ULL << power); b < edge; b++) cumulative += snap.latency[m][b];
+                out << "solve24_request_duration_seconds_bucket{mode=\"" << mode << "\",le=\""
+                    << (double)(1ULL << power) * 1e-9 << "\"} " << cumulative << "\n";
+            }
+            out << "solve24_request_duration_seconds_bucket{mode=\"" << mode << "\",le=\"+Inf\"} " << snap.requests[m] << "\n";
+            out << "solve24_request_duration_seconds_sum{mode=\"" << mode << "\"} " << (double)snap.latency_sum[m] * 1e-9 << "\n";
+            out << "solve24_request_duration_seconds_count{mode=\"" << mode << "\"} " << snap.requests[m] << "\n";
+        }
+        return out.str();
+    }
+
+    //writes to path.tmp and renames so scrapers never see a partial file (or, off windows,
+    //a missing one: rename replaces path in one step there)
+    bool dump_to_file(const std::string& path){
+        std::string text = exposition();
+        std::string tmp = path + ".tmp";
+        FILE* f = std::fopen(tmp.c_str(), "wb");
+        if(!f) return false;
+        bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+        ok = std::fclose(f) == 0 && ok;
+        if(!ok){
+            std::remove(tmp.c_str());
+            return false;
+        }
+#ifdef _WIN32
+        //rename does not replace an existing file here
+        std::remove(path.c_str());
+#endif
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    //serves one exposition per connection on a unix socket from a background
+    //thread, e.g. `socat - UNIX-CONNECT:path`. not available on windows
+    bool serve_socket(const std::string& path){
+#ifndef _WIN32
+        if(serving.load()) return false;
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0) return false;
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if(path.size() >= sizeof(addr.sun_path)){ close(fd); return false; }
+        path.copy(addr.sun_path, path.size());
+        unlink(path.c_str());
+        if(bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 8) != 0){
+            close(fd);
+            return false;
+        }
+        server_fd = fd;
+        socket_path = path;
+        serving.store(true);
+        server = std::thread([this](){
+            while(serving.load()){
+                int client = accept(server_fd, nullptr, nullptr);
+                if(client < 0) continue;
+                std::string text = exposition();
+                size_t sent = 0;
+                while(sent < text.size()){
+                    ssize_t n = write(client, text.data() + sent, text.size() - sent);
+                    if(n <= 0) break;
+                    sent += (size_t)n;
+                }
+                close(client);
+            }
+        });
+        return true;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    void stop_socket(){
+#ifndef _WIN32
+        if(!serving.exchange(false)) return;
+        shutdown(server_fd, SHUT_RDWR);
+        close(server_fd);
+        if(server.joinable()) server.join();
+        unlink(socket_path.c_str());
+        server_fd = -1;
+#endif
+    }
+};
+
+inline MetricsRegistry& metrics(){
+    static MetricsRegistry registry;
+    return registry;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//a hand that is ready to play: already checked solvable, with its first solution
+//and difficulty worked out
+struct PreparedHand{
+    std::vector<int> numbers;
+    long long target = 24;
+    int difficulty = 0;
+    std::string solution;
+};
+
+//keeps up to depth prepared hands ahead of the game. a background worker calls
+//prepare() until the queue is full and sleeps until something is taken, so the
+//consumer never pays for solving; try_pop never waits. after max_attempts rejected
+//draws in a row (no hand of that size makes the target, say) the worker gives up and
+//pop fails once the queue is empty, instead of waiting forever
+class PrefetchQueue{
+private:
+    std::function<bool(PreparedHand&)> prepare;
+    size_t depth;
+    size_t max_attempts;
+    bool exhausted;
+    std::deque<PreparedHand> ready;
+    std::mutex lock;
+    std::condition_variable space;
+    std::condition_variable filled;
+    bool stopping;
+    std::thread worker;
+
+    void run(){
+        for(;;){
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                space.wait(guard, [&]{ return stopping || ready.size() < depth; });
+                if(stopping) return;
+            }
+            //prepare returns false for a hand it rejects (say, unsolvable); just draw again
+            PreparedHand hand;
+            size_t attempts = 1;
+            bool made = prepare(hand);
+            for(; !made && attempts < max_attempts; attempts++) made = prepare(hand);
+            std::lock_guard<std::mutex> guard(lock);
+            if(!made){
+                exhausted = true;
+                filled.notify_all();
+                return;
+            }
+            ready.push_back(hand);
+            filled.notify_one();
+        }
+    }
+public:
+    PrefetchQueue(const std::function<bool(PreparedHand&)>& arg1, size_t arg2, size_t arg3 = 10000){
+        prepare = arg1;
+        depth = arg2 > 0 ? arg2 : 1;
+        max_attempts = arg3 > 0 ? arg3 : 1;
+        exhausted = false;
+        stopping = false;
+        worker = std::thread([this]{ run(); });
+    }
+    ~PrefetchQueue(){
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        space.notify_all();
+        worker.join();
+    }
+    PrefetchQueue(const PrefetchQueue&) = delete;
+    PrefetchQueue& operator=(const PrefetchQueue&) = delete;
+
+    size_t size(){
+        std::lock_guard<std::mutex> guard(lock);
+        return ready.size();
+    }
+    bool try_pop(PreparedHand& out){
+        std::lock_guard<std::mutex> guard(lock);
+        if(ready.empty()) return false;
+        out = ready.front();
+        ready.pop_front();
+        space.notify_one();
+        return true;
+    }
+    //for callers that have nothing better to do than wait, such as a feeder process.
+    //false once the worker has given up and every prepared hand has been taken
+    bool pop(PreparedHand& out){
+        std::unique_lock<std::mutex> guard(lock);
+        filled.wait(guard, [&]{ return !ready.empty() || exhausted; });
+        if(ready.empty()) return false;
+        out = ready.front();
+        ready.pop_front();
+        space.notify_one();
+        return true;
+    }
+};
@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "metrics.h"
+
+//progress of long enumerations over the hand space. every worker owns one cache-line
+//aligned WorkerProgress and publishes into it with relaxed load/store (one writer per
+//slot, as with metrics shards), so the hot path has no atomic read-modify-write and no
+//shared line. a reporter thread sums the slots every interval, keeps a moving window of
+//those samples and turns it into throughput and an ETA
+struct alignas(64) WorkerProgress{
+    std::atomic<uint64_t> hands;
+    std::atomic<uint64_t> nodes;
+    //the rank range the worker is on, [begin, end); equal when idle
+    std::atomic<uint64_t> range_begin;
+    std::atomic<uint64_t> range_end;
+
+    WorkerProgress(){
+        hands.store(0, std::memory_order_relaxed);
+        nodes.store(0, std::memory_order_relaxed);
+        range_begin.store(0, std::memory_order_relaxed);
+        range_end.store(0, std::memory_order_relaxed);
+    }
+    void claim(uint64_t begin, uint64_t end){
+        range_begin.store(begin, std::memory_order_relaxed);
+        range_end.store(end, std::memory_order_relaxed);
+    }
+    void finish_hand(uint64_t hand_nodes){
+        bump(hands, 1);
+        bump(nodes, hand_nodes);
+    }
+};
+
+struct ProgressReport{
+    uint64_t total = 0;
+    uint64_t hands = 0;
+    uint64_t nodes = 0;
+    double elapsed = 0;
+    //over the moving window, or since the start while the window is still filling
+    double hands_per_second = 0;
+    double nodes_per_second = 0;
+    //seconds left at the window's rate; negative while there is no rate yet
+    double eta = -1;
+    //per worker, the rank range in flight
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+
+    double fraction() const { return total ? (double)hands / (double)total : 1; }
+    std::string to_string() const {
+        std::ostringstream out;
+        out.precision(3);
+        out << hands << "/" << total << " hands (" << 100 * fraction() << "%), " << nodes << " nodes, "
+            << hands_per_second << " hands/s, " << nodes_per_second << " nodes/s, eta ";
+        if(eta < 0) out << "unknown";
+        else out << eta << " s";
+        out << ", ranges";
+        for(size_t i = 0; i < ranges.size(); i++){
+            if(ranges[i].first == ranges[i].second) out << " idle";
+            else out << " " << ranges[i].first << "-" << ranges[i].second;
+        }
+        return out.str();
+    }
+};
+
+class ProgressBoard{
+private:
+    struct Sample{
+        double at;
+        uint64_t hands;
+        uint64_t nodes;
+    };
+    uint64_t total;
+    int workers;
+    double window;
+    std::unique_ptr<WorkerProgress[]> slots;
+    std::chrono::steady_clock::time_point start;
+    //only the reporter (or a caller of report()) touches these
+    std::mutex samples_lock;
+    std::deque<Sample> samples;
+    std::thread reporter;
+    std::mutex stop_lock;
+    std::condition_variable stop_signal;
+    bool stopping;
+public:
+    //window is the span in seconds the throughput is averaged over
+    ProgressBoard(uint64_t arg1, int arg2, double arg3 = 30) : total(arg1), workers(std::max(1, arg2)), window(arg3),
+        slots(new WorkerProgress[std::max(1, arg2)]), start(std::chrono::steady_clock::now()), stopping(false) {}
+    ~ProgressBoard(){ stop_reporter(); }
+    ProgressBoard(const ProgressBoard&) = delete;
+    ProgressBoard& operator=(const ProgressBoard&) = delete;
+
+    int get_workers() const { return workers; }
+    uint64_t get_total() const { return total; }
+    WorkerProgress& worker(int i){ return slots[i]; }
+
+    //sums the slots now and adds the sample to the window
+    ProgressReport report(){
+        ProgressReport r;
+        r.total = total;
+        r.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for(int i = 0; i < workers; i++){
+            r.hands += slots[i].hands.load(std::memory_order_relaxed);
+            r.nodes += slots[i].nodes.load(std::memory_order_relaxed);
+            r.ranges.push_back(std::make_pair(slots[i].range_begin.load(std::memory_order_relaxed), slots[i].range_end.load(std::memory_order_relaxed)));
+        }
+        std::lock_guard<std::mutex> guard(samples_lock);
+        if(samples.empty()) samples.push_back(Sample{0, 0, 0});
+        samples.push_back(Sample{r.elapsed, r.hands, r.nodes});
+        while(samples.size() > 2 && samples[1].at <= r.elapsed - window) samples.pop_front();
+        const Sample& oldest = samples.front();
+        double span = r.elapsed - oldest.at;
+        if(span > 0){
+            r.hands_per_second = (double)(r.hands - oldest.hands) / span;
+            r.nodes_per_second = (double)(r.nodes - oldest.nodes) / span;
+        }
+        if(r.hands >= total) r.eta = 0;
+        else if(r.hands_per_second > 0) r.eta = (double)(total - r.hands) / r.hands_per_second;
+        return r;
+    }
+
+    //calls print(report()) every interval seconds on its own thread until stop_reporter
+    void start_reporter(double interval, std::function<void(const ProgressReport&)> print){
+        stop_reporter();
+        stopping = false;
+        reporter = std::thread([this, interval, print](){
+            std::unique_lock<std::mutex> lock(stop_lock);
+            while(!stop_signal.wait_for(lock, std::chrono::duration<double>(interval), [this](){ return stopping; })){
+                lock.unlock();
+                print(report());
+                lock.lock();
+            }
+        });
+    }
+    void stop_reporter(){
+        {
+            std::lock_guard<std::mutex> guard(stop_lock);
+            stopping = true;
+        }
+        stop_signal.notify_all();
+        if(reporter.joinable()) reporter.join();
+    }
+};
+
+//runs work(rank) for every rank in [0, hands) on threads workers, which claim CHUNK ranks
+//at a time from one shared cursor (one fetch_add per chunk, not per hand). work returns
+//the nodes it searched; with a board (made for at least threads workers) each worker
+//publishes its range, hands and nodes to its own slot
+template<class Work>
+inline void for_each_rank(uint64_t hands, int threads, ProgressBoard* board, Work&& work){
+    const uint64_t CHUNK = 256;
+    threads = std::max(1, threads);
+    std::atomic<uint64_t> cursor(0);
+    auto run = [&](int w){
+        WorkerProgress* slot = board ? &board->worker(w) : nullptr;
+        for(;;){
+            uint64_t begin = cursor.fetch_add(CHUNK, std::memory_order_relaxed);
+            if(begin >= hands) break;
+            uint64_t end = std::min(hands, begin + CHUNK);
+            if(slot) slot->claim(begin, end);
+            for(uint64_t rank = begin; rank < end; rank++){
+                uint64_t nodes = work(rank);
+                if(slot) slot->finish_hand(nodes);
+            }
+        }
+        if(slot) slot->claim(0, 0);
+    };
+    std::vector<std::thread> pool;
+    for(int w = 1; w < threads; w++) pool.push_back(std::thread(run, w));
+    run(0);
+    for(size_t i = 0; i < pool.size(); i++) pool[i].join();
+}
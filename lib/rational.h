@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <functional>
+
+//exact fraction num/den with den > 0 and gcd(num, den) == 1
+//arithmetic goes through __int128 and reports overflow instead of wrapping
+struct Rational{
+    long long num;
+    long long den;
+
+    Rational() : num(0), den(1) {}
+    Rational(long long n) : num(n), den(1) {}
+    Rational(long long n, long long d) : num(n), den(d) { normalize(); }
+
+    bool is_integer() const { return den == 1; }
+    double to_double() const { return (double)num / (double)den; }
+
+    std::string to_string() const {
+        if(den == 1) return std::to_string(num);
+        return std::to_string(num) + "/" + std::to_string(den);
+    }
+
+    static bool make(__int128 n, __int128 d, Rational& out){
+        if(d == 0) return false;
+        if(d < 0){ n = -n; d = -d; }
+        __int128 a = n < 0 ? -n : n, b = d;
+        while(b != 0){ __int128 t = a % b; a = b; b = t; }
+        if(a > 1){ n /= a; d /= a; }
+        if(n > INT64_MAX || n < -INT64_MAX || d > INT64_MAX) return false;
+        out.num = (long long)n;
+        out.den = (long long)d;
+        return true;
+    }
+
+private:
+    void normalize(){
+        Rational r;
+        if(make(num, den, r)) *this = r;
+        else { num = 0; den = 1; }
+    }
+};
+
+inline bool add(const Rational& a, const Rational& b, Rational& out){
+    return Rational::make((__int128)a.num * b.den + (__int128)b.num * a.den, (__int128)a.den * b.den, out);
+}
+inline bool sub(const Rational& a, const Rational& b, Rational& out){
+    return Rational::make((__int128)a.num * b.den - (__int128)b.num * a.den, (__int128)a.den * b.den, out);
+}
+inline bool mul(const Rational& a, const Rational& b, Rational& out){
+    return Rational::make((__int128)a.num * b.num, (__int128)a.den * b.den, out);
+}
+inline bool div(const Rational& a, const Rational& b, Rational& out){
+    if(b.num == 0) return false;
+    return Rational::make((__int128)a.num * b.den, (__int128)a.den * b.num, out);
+}
+
+inline bool operator==(const Rational& a, const Rational& b){ return a.num == b.num && a.den == b.den; }
+inline bool operator!=(const Rational& a, const Rational& b){ return !(a == b); }
+inline bool operator<(const Rational& a, const Rational& b){
+    return (__int128)a.num * b.den < (__int128)b.num * a.den;
+}
+
+//reads "7", "-3/4" or "0.25" exactly, a decimal as its digits over a power of ten; false
+//for anything else, a zero denominator or a part past long long
+inline bool parse_rational(const std::string& text, Rational& out){
+    size_t at = 0;
+    bool negative = false;
+    if(at < text.size() && (text[at] == '-' || text[at] == '+')) negative = text[at++] == '-';
+    __int128 num = 0, den = 1;
+    size_t digits = 0;
+    for(; at < text.size() && text[at] >= '0' && text[at] <= '9'; at++, digits++){
+        num = num * 10 + (text[at] - '0');
+        if(num > INT64_MAX) return false;
+    }
+    if(at < text.size() && text[at] == '.'){
+        for(at++; at < text.size() && text[at] >= '0' && text[at] <= '9'; at++, digits++){
+            num = num * 10 + (text[at] - '0');
+            den *= 10;
+            if(num > INT64_MAX || den > INT64_MAX) return false;
+        }
+    }
+    else if(at < text.size() && text[at] == '/' && digits > 0){
+        den = 0;
+        size_t den_digits = 0;
+        for(at++; at < text.size() && text[at] >= '0' && text[at] <= '9'; at++, den_digits++){
+            den = den * 10 + (text[at] - '0');
+            if(den > INT64_MAX) return false;
+        }
+        if(den_digits == 0) return false;
+    }
+    if(digits == 0 || at != text.size()) return false;
+    return Rational::make(negative ? -num : num, den, out);
+}
+
+struct RationalHash{
+    size_t operator()(const Rational& r) const {
+        uint64_t h = (uint64_t)r.num * 0x9E3779B97F4A7C15ULL ^ (uint64_t)r.den * 0xC2B2AE3D27D4EB4FULL;
+        return (size_t)(h ^ (h >> 29));
+    }
+};
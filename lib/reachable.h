@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "rational.h"
+
+//dynamic programming over subsets: values[mask] holds every value reachable by
+//combining exactly the numbers in mask with {+, -, *, /}. each subset is built
+//once from its two-way splits, so repeated sub-hands are never re-searched
+namespace reach{
+
+typedef std::vector<Rational> ValueSet;
+
+inline void sort_unique(ValueSet& values){
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+//calls visit(result) for a+b, a*b, a-b, b-a, a/b, b/a, skipping overflow and x/0
+template<class Visit>
+inline void for_each_combination(const Rational& a, const Rational& b, Visit&& visit){
+    Rational r;
+    if(add(a, b, r)) visit(r);
+    if(mul(a, b, r)) visit(r);
+    if(sub(a, b, r)) visit(r);
+    if(sub(b, a, r)) visit(r);
+    if(div(a, b, r)) visit(r);
+    if(div(b, a, r)) visit(r);
+}
+
+//calls split(left, right) once per unordered split of mask into two non-empty parts
+template<class Split>
+inline void for_each_split(uint32_t mask, Split&& split){
+    uint32_t low = mask & (~mask + 1);
+    for(uint32_t left = (mask - 1) & mask; left > 0; left = (left - 1) & mask){
+        if(!(left & low)) continue;
+        split(left, mask ^ left);
+    }
+}
+
+inline void combine_sets(const ValueSet& left, const ValueSet& right, ValueSet& out){
+    for(size_t i = 0; i < left.size(); i++)
+        for(size_t j = 0; j < right.size(); j++)
+            for_each_combination(left[i], right[j], [&](const Rational& r){ out.push_back(r); });
+}
+
+//tables for every subset of nums; the full mask is skipped when include_full is false,
+//which is what callers that only probe the top level via meet-in-the-middle want
+inline std::vector<ValueSet> subset_tables(const std::vector<Rational>& nums, bool include_full = true){
+    uint32_t full = (1u << nums.size()) - 1;
+    std::vector<ValueSet> values(full + 1);
+    for(size_t i = 0; i < nums.size(); i++)
+        values[1u << i].push_back(nums[i]);
+    for(uint32_t mask = 1; mask <= full; mask++){
+        if((mask & (mask - 1)) == 0) continue;
+        if(mask == full && !include_full) continue;
+        ValueSet& out = values[mask];
+        for_each_split(mask, [&](uint32_t left, uint32_t right){
+            combine_sets(values[left], values[right], out);
+        });
+        sort_unique(out);
+    }
+    return values;
+}
+
+inline ValueSet reachable_values(const std::vector<Rational>& nums){
+    if(nums.empty()) return ValueSet();
+    return subset_tables(nums).back();
+}
+
+//sets bit (t - lo) in bits for every integer t in [lo, hi] reachable from nums
+//the full mask is never materialised, only its integer results are marked.
+//returns the value pairs combined at the top level, a measure of the work done
+inline uint64_t mark_integer_targets(const std::vector<Rational>& nums, long long lo, long long hi, uint64_t* bits){
+    if(nums.size() == 1){
+        if(nums[0].is_integer() && nums[0].num >= lo && nums[0].num <= hi)
+            bits[(nums[0].num - lo) >> 6] |= 1ULL << ((nums[0].num - lo) & 63);
+        return 1;
+    }
+    uint64_t pairs = 0;
+    std::vector<ValueSet> values = subset_tables(nums, false);
+    uint32_t full = (1u << nums.size()) - 1;
+    for_each_split(full, [&](uint32_t left, uint32_t right){
+        const ValueSet& a = values[left];
+        const ValueSet& b = values[right];
+        pairs += a.size() * b.size();
+        for(size_t i = 0; i < a.size(); i++)
+            for(size_t j = 0; j < b.size(); j++)
+                for_each_combination(a[i], b[j], [&](const Rational& r){
+                    if(r.is_integer() && r.num >= lo && r.num <= hi)
+                        bits[(r.num - lo) >> 6] |= 1ULL << ((r.num - lo) & 63);
+                });
+    });
+    return pairs;
+}
+
+inline std::vector<Rational> to_rationals(const std::vector<int>& nums){
+    return std::vector<Rational>(nums.begin(), nums.end());
+}
+
+}
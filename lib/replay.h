@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "metrics.h"
+#include "request_log.h"
+#ifndef _WIN32
+#include <climits>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+//drives a solver with a captured request stream and reports throughput and
+//latency percentiles. schedules:
+//  closed loop (default): each worker sends its next request as soon as the last returns
+//  fixed rate: request i is due at i / rate seconds
+//  open loop: request i is due at its captured offset divided by speed
+//for the two open schedules latency is measured from the due time, not the send
+//time, so a stalled solver shows up as queueing delay instead of being hidden
+enum class ReplaySchedule { closed_loop, fixed_rate, open_loop };
+
+struct ReplayOptions{
+    ReplaySchedule schedule = ReplaySchedule::closed_loop;
+    int threads = 1;
+    double rate = 1000;
+    double speed = 1;
+    int loops = 1;
+};
+
+struct ReplayReport{
+    uint64_t requests = 0;
+    //requests the handler could not answer; the first one stops the replay
+    uint64_t failed = 0;
+    double seconds = 0;
+    uint64_t per_mode[SOLVE_MODE_COUNT] = {};
+    std::vector<uint64_t> latency = std::vector<uint64_t>(HISTOGRAM_BUCKETS, 0);
+    std::vector<uint64_t> mode_latency[SOLVE_MODE_COUNT];
+
+    void print(std::ostream& out) const {
+        out << "requests " << requests << " in " << seconds << " s, " << (seconds > 0 ? requests / seconds : 0) << " req/s";
+        if(failed > 0) out << ", " << failed << " failed (replay stopped)";
+        out << std::endl;
+        print_line(out, "all", latency, requests);
+        for(int m = 0; m < SOLVE_MODE_COUNT; m++)
+            if(per_mode[m] > 0) print_line(out, solve_mode_name((SolveMode)m), mode_latency[m], per_mode[m]);
+    }
+private:
+    static void print_line(std::ostream& out, const char* name, const std::vector<uint64_t>& buckets, uint64_t count){
+        out << "  " << name << " (" << count << "): p50 " << histogram_quantile(buckets, 0.50) / 1000.0
+            << " us, p90 " << histogram_quantile(buckets, 0.90) / 1000.0
+            << " us, p99 " << histogram_quantile(buckets, 0.99) / 1000.0
+            << " us, p99.9 " << histogram_quantile(buckets, 0.999) / 1000.0
+            << " us, max " << histogram_quantile(buckets, 1.0) / 1000.0 << " us" << std::endl;
+    }
+};
+
+//make_handler(worker) returns the function that worker uses to run one request; it returns
+//false when the request got no answer
+typedef std::function<bool(const SolveRequest&)> RequestHandler;
+
+inline ReplayReport replay(const std::vector<SolveRequest>& requests, const ReplayOptions& options,
+                           const std::function<RequestHandler(int)>& make_handler){
+    typedef std::chrono::steady_clock clock;
+    ReplayReport report;
+    if(requests.empty() || options.threads < 1) return report;
+    uint64_t total = (uint64_t)requests.size() * (uint64_t)options.loops;
+    //offsets from the earliest request, so a capture out of order cannot wrap around
+    uint64_t first = requests.front().offset_ns, last = first;
+    for(size_t i = 0; i < requests.size(); i++){
+        first = std::min(first, requests[i].offset_ns);
+        last = std::max(last, requests[i].offset_ns);
+    }
+    uint64_t span = last - first + 1;
+    std::atomic<uint64_t> next(0);
+    std::vector<ReplayReport> partial(options.threads);
+    std::vector<std::thread> workers;
+    clock::time_point start = clock::now() + std::chrono::milliseconds(10);
+    for(int w = 0; w < options.threads; w++){
+        workers.emplace_back([&, w](){
+            RequestHandler handle = make_handler(w);
+            ReplayReport& mine = partial[w];
+            for(int m = 0; m < SOLVE_MODE_COUNT; m++) mine.mode_latency[m].assign(HISTOGRAM_BUCKETS, 0);
+            std::this_thread::sleep_until(start);
+            for(;;){
+                uint64_t i = next.fetch_add(1);
+                if(i >= total) break;
+                const SolveRequest& request = requests[i % requests.size()];
+                clock::time_point due = clock::now();
+                if(options.schedule == ReplaySchedule::fixed_rate){
+                    due = start + std::chrono::nanoseconds((uint64_t)((double)i * 1e9 / options.rate));
+                }
+                else if(options.schedule == ReplaySchedule::open_loop){
+                    uint64_t offset = (i / requests.size()) * span + (request.offset_ns - first);
+                    due = start + std::chrono::nanoseconds((uint64_t)((double)offset / options.speed));
+                }
+                std::this_thread::sleep_until(due);
+                if(!handle(request)){
+                    mine.failed++;
+                    next.store(total);
+                    break;
+                }
+                uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - due).count();
+                int bucket = histogram_bucket(ns);
+                mine.latency[bucket]++;
+                mine.mode_latency[(int)request.mode][bucket]++;
+                mine.per_mode[(int)request.mode]++;
+                mine.requests++;
+            }
+        });
+    }
+    for(size_t w = 0; w < workers.size(); w++) workers[w].join();
+    report.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    for(int m = 0; m < SOLVE_MODE_COUNT; m++) report.mode_latency[m].assign(HISTOGRAM_BUCKETS, 0);
+    for(size_t w = 0; w < partial.size(); w++){
+        report.requests += partial[w].requests;
+        report.failed += partial[w].failed;
+        for(int b = 0; b < HISTOGRAM_BUCKETS; b++){
+            report.latency[b] += partial[w].latency[b];
+            for(int m = 0; m < SOLVE_MODE_COUNT; m++) report.mode_latency[m][b] += partial[w].mode_latency[m][b];
+        }
+        for(int m = 0; m < SOLVE_MODE_COUNT; m++) report.per_mode[m] += partial[w].per_mode[m];
+    }
+    return report;
+}
+
+#ifndef _WIN32
+//the running binary, for starting copies of it: /proc/self/exe where there is one, else
+//argv0 (which DaemonClient looks up on PATH when it has no slash)
+inline std::string self_program(const char* argv0){
+    char path[PATH_MAX];
+    ssize_t size = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if(size <= 0) return argv0;
+    path[size] = 0;
+    return path;
+}
+
+//a child process running `<program> solve`, spoken to over its stdin/stdout;
+//each request is one line out and one line back. a child that cannot start or dies
+//makes call return false; the caller should ignore SIGPIPE, or writing to it kills this process
+class DaemonClient{
+private:
+    pid_t pid;
+    FILE* to_child;
+    FILE* from_child;
+public:
+    explicit DaemonClient(const std::string& program) : pid(-1), to_child(nullptr), from_child(nullptr) {
+        int in_pipe[2], out_pipe[2];
+        if(pipe(in_pipe) != 0) return;
+        if(pipe(out_pipe) != 0){ close(in_pipe[0]); close(in_pipe[1]); return; }
+        //later children must not inherit this child's pipe ends or it never sees EOF
+        int ends[4] = {in_pipe[0], in_pipe[1], out_pipe[0], out_pipe[1]};
+        for(int i = 0; i < 4; i++) fcntl(ends[i], F_SETFD, FD_CLOEXEC);
+        pid = fork();
+        if(pid == 0){
+            dup2(in_pipe[0], 0);
+            dup2(out_pipe[1], 1);
+            close(in_pipe[0]); close(in_pipe[1]); close(out_pipe[0]); close(out_pipe[1]);
+            execlp(program.c_str(), program.c_str(), "solve", (char*)nullptr);
+            _exit(127);
+        }
+        close(in_pipe[0]);
+        close(out_pipe[1]);
+        to_child = fdopen(in_pipe[1], "w");
+        from_child = fdopen(out_pipe[0], "r");
+    }
+    ~DaemonClient(){
+        if(to_child) std::fclose(to_child);
+        if(from_child) std::fclose(from_child);
+        if(pid > 0) waitpid(pid, nullptr, 0);
+    }
+    DaemonClient(const DaemonClient&) = delete;
+    DaemonClient& operator=(const DaemonClient&) = delete;
+
+    bool ok() const { return pid > 0 && to_child && from_child; }
+    bool call(const SolveRequest& request, std::string& response){
+        if(!ok()) return false;
+        std::string line = format_request(request) + "\n";
+        if(std::fputs(line.c_str(), to_child) < 0 || std::fflush(to_child) != 0) return false;
+        response.clear();
+        char buffer[4096];
+        while(std::fgets(buffer, sizeof(buffer), from_child)){
+            response += buffer;
+            if(!response.empty() && response.back() == '\n') return true;
+        }
+        return false;
+    }
+};
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "filter_spec.h"
+#include "metrics.h"
+#include "rational.h"
+
+//one solver query. the capture format is a text file starting with
+//"# solve24-capture v1", then one request per line:
+//    <offset_ns> <exists|first|all|count|best> <target> <n1> <n2> ... [filter tokens] [top=K]
+//offset_ns is the arrival time relative to the start of the capture; numbers (and the
+//target) may be ints, fractions "3/4" or decimals "0.25", see parse_rational, and are
+//written back exactly (Rational::to_string), so a capture replays the same queries; the optional
+//tokens after the numbers are a FilterSpec (see parse_filter_token) and, for best,
+//how many solutions to return
+struct SolveRequest{
+    uint64_t offset_ns = 0;
+    SolveMode mode = SolveMode::exists;
+    Rational target = 24;
+    std::vector<Rational> numbers;
+    FilterSpec filter;
+    size_t top = 3;
+};
+
+inline bool parse_solve_mode(const std::string& name, SolveMode& mode){
+    if(name == "exists") mode = SolveMode::exists;
+    else if(name == "first") mode = SolveMode::first;
+    else if(name == "all") mode = SolveMode::all;
+    else if(name == "count") mode = SolveMode::count;
+    else if(name == "best") mode = SolveMode::best;
+    else return false;
+    return true;
+}
+
+//"<mode> <target> <numbers...> [ops=+* must=/ whole nonneg] [top=K]", the request part of a capture line
+inline bool parse_request(std::istream& in, SolveRequest& request){
+    std::string name, target;
+    if(!(in >> name >> target) || !parse_solve_mode(name, request.mode)) return false;
+    if(!parse_rational(target, request.target)){
+        //captures from before targets were written exactly may hold "2e+06"; only a whole
+        //number is taken from those, anything else was already rounded
+        char* end = nullptr;
+        double value = std::strtod(target.c_str(), &end);
+        if(end == target.c_str() || *end != '\0' || value != std::floor(value) || std::fabs(value) > 9e18) return false;
+        request.target = Rational((long long)value);
+    }
+    request.numbers.clear();
+    request.filter = FilterSpec();
+    request.top = 3;
+    std::string token;
+    bool reading_numbers = true;
+    while(in >> token){
+        Rational value;
+        if(reading_numbers && parse_rational(token, value)){
+            request.numbers.push_back(value);
+            continue;
+        }
+        reading_numbers = false;
+        if(token.compare(0, 4, "top=") == 0){
+            request.top = std::strtoull(token.c_str() + 4, nullptr, 10);
+            if(request.top == 0) return false;
+        }
+        else if(!parse_filter_token(token, request.filter)) return false;
+    }
+    return !request.numbers.empty();
+}
+
+inline std::string format_request(const SolveRequest& request){
+    std::ostringstream out;
+    out << solve_mode_name(request.mode) << " " << request.target.to_string();
+    for(size_t i = 0; i < request.numbers.size(); i++) out << " " << request.numbers[i].to_string();
+    std::string filter = format_filter(request.filter);
+    if(!filter.empty()) out << " " << filter;
+    if(request.mode == SolveMode::best && request.top != 3) out << " top=" << request.top;
+    return out.str();
+}
+
+inline bool read_capture(const std::string& path, std::vector<SolveRequest>& requests){
+    std::ifstream in(path);
+    if(!in) return false;
+    std::string line;
+    while(std::getline(in, line)){
+        if(line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        SolveRequest request;
+        if(!(fields >> request.offset_ns) || !parse_request(fields, request)) return false;
+        requests.push_back(request);
+    }
+    return true;
+}
+
+//appends requests with their arrival offsets; safe to share between threads
+class CaptureWriter{
+private:
+    std::ofstream out;
+    std::mutex lock;
+    std::chrono::steady_clock::time_point start;
+public:
+    bool open(const std::string& path){
+        out.open(path, std::ios::out | std::ios::trunc);
+        start = std::chrono::steady_clock::now();
+        if(out) out << "# solve24-capture v1\n";
+        return (bool)out;
+    }
+    bool is_open() const { return out.is_open(); }
+    //the offset is taken under the lock, so offsets in the file never go backwards
+    void write(const SolveRequest& request){
+        std::string line = format_request(request);
+        std::lock_guard<std::mutex> guard(lock);
+        uint64_t offset = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        out << offset << " " << line << "\n";
+    }
+    void flush(){
+        std::lock_guard<std::mutex> guard(lock);
+        out.flush();
+    }
+};
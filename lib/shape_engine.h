@@ -0,0 +1,295 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//every expression over a hand, enumerated as three independent choices instead of the
+//pairwise-reduction recursion: a tree shape, an order of the numbers on its leaves, and
+//an operator per internal node. shapes for n leaves (catalan(n - 1) of them) are built
+//once per n and shared; leaf orders come from heap's algorithm, one swap apart, with
+//repeats from equal numbers skipped; operator assignments are walked as a reflected
+//base-4 gray code, so consecutive expressions differ in one operator and only that node
+//and its ancestors are recomputed. after construction nothing is allocated
+namespace shapes{
+
+const int MAX_LEAVES = 8;
+const uint8_t NO_PARENT = 255;
+
+//internal nodes in postorder. slot i < leaves is leaf i (left to right); slot leaves + k is
+//internal node k, whose children are slots left[k] and right[k]; the root is the last node.
+//by_depth lists the nodes root first, shallowest to deepest: the gray walk gives the digit
+//that moves most to the node with the shortest path to recompute
+struct Shape{
+    int leaves;
+    uint8_t left[MAX_LEAVES - 1];
+    uint8_t right[MAX_LEAVES - 1];
+    uint8_t parent[MAX_LEAVES - 1];
+    uint8_t by_depth[MAX_LEAVES - 1];
+};
+
+//a subtree while shapes are built: its internal nodes in postorder, children referenced
+//as leaf index or, from LOCAL up, as LOCAL + position in this list
+struct Partial{
+    static const uint8_t LOCAL = 64;
+    std::vector<uint8_t> left;
+    std::vector<uint8_t> right;
+
+    uint8_t root_ref(uint8_t first_leaf) const { return left.empty() ? first_leaf : (uint8_t)(LOCAL + left.size() - 1); }
+};
+
+inline std::vector<Partial> build_partials(int first, int count){
+    std::vector<Partial> out;
+    if(count == 1){
+        out.push_back(Partial());
+        return out;
+    }
+    for(int split = 1; split < count; split++){
+        std::vector<Partial> lefts = build_partials(first, split);
+        std::vector<Partial> rights = build_partials(first + split, count - split);
+        for(size_t a = 0; a < lefts.size(); a++){
+            for(size_t b = 0; b < rights.size(); b++){
+                Partial joined = lefts[a];
+                uint8_t shift = (uint8_t)joined.left.size();
+                for(size_t k = 0; k < rights[b].left.size(); k++){
+                    uint8_t l = rights[b].left[k], r = rights[b].right[k];
+                    joined.left.push_back(l >= Partial::LOCAL ? (uint8_t)(l + shift) : l);
+                    joined.right.push_back(r >= Partial::LOCAL ? (uint8_t)(r + shift) : r);
+                }
+                uint8_t right_root = rights[b].root_ref((uint8_t)(first + split));
+                joined.left.push_back(lefts[a].root_ref((uint8_t)first));
+                joined.right.push_back(right_root >= Partial::LOCAL ? (uint8_t)(right_root + shift) : right_root);
+                out.push_back(joined);
+            }
+        }
+    }
+    return out;
+}
+
+//catalan(leaves - 1) shapes, built on first use and kept for the life of the process
+inline const std::vector<Shape>& shapes_for(int leaves){
+    static std::mutex lock;
+    static std::vector<Shape> cache[MAX_LEAVES + 1];
+    std::lock_guard<std::mutex> guard(lock);
+    if(leaves < 1 || leaves > MAX_LEAVES) return cache[0];
+    std::vector<Shape>& shapes = cache[leaves];
+    if(!shapes.empty()) return shapes;
+    std::vector<Partial> partials = build_partials(0, leaves);
+    for(size_t s = 0; s < partials.size(); s++){
+        Shape shape;
+        shape.leaves = leaves;
+        int nodes = leaves - 1;
+        for(int k = 0; k < nodes; k++){
+            uint8_t l = partials[s].left[k], r = partials[s].right[k];
+            shape.left[k] = l >= Partial::LOCAL ? (uint8_t)(leaves + l - Partial::LOCAL) : l;
+            shape.right[k] = r >= Partial::LOCAL ? (uint8_t)(leaves + r - Partial::LOCAL) : r;
+            shape.parent[k] = NO_PARENT;
+        }
+        for(int k = 0; k < nodes; k++){
+            if(shape.left[k] >= leaves) shape.parent[shape.left[k] - leaves] = (uint8_t)k;
+            if(shape.right[k] >= leaves) shape.parent[shape.right[k] - leaves] = (uint8_t)k;
+        }
+        int depth[MAX_LEAVES - 1];
+        for(int k = nodes - 1; k >= 0; k--){
+            depth[k] = shape.parent[k] == NO_PARENT ? 0 : depth[shape.parent[k]] + 1;
+            shape.by_depth[nodes - 1 - k] = (uint8_t)k;
+        }
+        std::stable_sort(shape.by_depth, shape.by_depth + nodes, [&](uint8_t a, uint8_t b){ return depth[a] < depth[b]; });
+        shapes.push_back(shape);
+    }
+    return shapes;
+}
+
+//operators 0-3 are + - * /, and with reversals 4 and 5 are b - a and b / a
+const int OPS = 4;
+const int OPS_WITH_REVERSALS = 6;
+
+inline double apply(int op, double a, double b){
+    switch(op){
+        case 0: return a + b;
+        case 1: return a - b;
+        case 2: return a * b;
+        case 3: return a / b;
+        case 4: return b - a;
+        default: return b / a;
+    }
+}
+
+class ExpressionEngine{
+private:
+    int leaves;
+    const Shape* shape;
+    double slots[2 * MAX_LEAVES - 1];
+    double leaf_values[MAX_LEAVES];
+    int ops[MAX_LEAVES - 1];
+    int direction[MAX_LEAVES - 1];
+    int radix;
+    uint64_t evaluations;
+    double distinct[MAX_LEAVES];
+    int distinct_count;
+    //leaf orders already walked for the current shape, as packed distinct-value indices;
+    //only used when the hand has equal numbers. sized once for MAX_LEAVES!, and a hand of
+    //n numbers uses (and clears) the first seen_mask + 1 >= 2 * n! entries
+    std::vector<uint64_t> seen;
+    size_t seen_mask;
+
+    void evaluate_all(){
+        for(int k = 0; k < leaves - 1; k++)
+            slots[leaves + k] = apply(ops[k], slots[shape->left[k]], slots[shape->right[k]]);
+        evaluations += leaves - 1;
+    }
+    //the changed node and its spine up to the root, nothing else
+    void evaluate_from(int k){
+        for(; k != NO_PARENT; k = shape->parent[k]){
+            slots[leaves + k] = apply(ops[k], slots[shape->left[k]], slots[shape->right[k]]);
+            evaluations++;
+        }
+    }
+    void reset_ops(){
+        for(int k = 0; k < leaves - 1; k++){
+            ops[k] = 0;
+            direction[k] = 1;
+        }
+    }
+    bool first_visit(){
+        if(distinct_count == leaves) return true;
+        uint64_t key = 1;
+        for(int i = 0; i < leaves; i++)
+            key = key << 3 | (uint64_t)(std::find(distinct, distinct + distinct_count, leaf_values[i]) - distinct);
+        size_t at = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 40) & seen_mask;
+        while(seen[at] != 0){
+            if(seen[at] == key) return false;
+            at = (at + 1) & seen_mask;
+        }
+        seen[at] = key;
+        return true;
+    }
+    //every operator assignment (radix^(leaves - 1)) for the current shape and leaf order, as a
+    //reflected gray code: the lowest digit that can move in its direction moves and the ones
+    //below it turn around. digit d is node by_depth[d], so on average about one node and a
+    //short spine are recomputed per expression. the walk ends with every direction reversed,
+    //so the next leaf order walks the codes backwards
+    template<class Visit>
+    bool walk_ops(Visit& visit){
+        int nodes = leaves - 1;
+        evaluate_all();
+        if(visit(slots[leaves + nodes - 1])) return true;
+        for(;;){
+            int d = 0;
+            for(; d < nodes; d++){
+                int k = shape->by_depth[d];
+                int moved = ops[k] + direction[k];
+                if(moved >= 0 && moved < radix){
+                    ops[k] = moved;
+                    evaluate_from(k);
+                    break;
+                }
+                direction[k] = -direction[k];
+            }
+            if(d == nodes) return false;
+            if(visit(slots[leaves + nodes - 1])) return true;
+        }
+    }
+public:
+    ExpressionEngine() : leaves(0), shape(nullptr), radix(OPS), evaluations(0), distinct_count(0), seen_mask(0) {
+        size_t orders = 1;
+        for(int i = 2; i <= MAX_LEAVES; i++) orders *= i;
+        size_t size = 1;
+        while(size < 2 * orders) size <<= 1;
+        seen.assign(size, 0);
+    }
+    ExpressionEngine(const ExpressionEngine&) = delete;
+    ExpressionEngine& operator=(const ExpressionEngine&) = delete;
+
+    //internal nodes computed since construction: full enumeration stays near one per expression
+    uint64_t get_evaluations() const { return evaluations; }
+
+    //calls visit(value) for each operator assignment of one shape with its leaves in the given
+    //order; with reversals the operators include b - a and b / a (6^(n-1) assignments), which
+    //covers both child orders of every node without permuting the leaves
+    template<class Visit>
+    bool for_each_assignment(const Shape& fixed, const double* ordered, bool reversals, Visit&& visit){
+        leaves = fixed.leaves;
+        shape = &fixed;
+        radix = reversals ? OPS_WITH_REVERSALS : OPS;
+        std::copy(ordered, ordered + leaves, slots);
+        reset_ops();
+        bool stop = leaves == 1 ? (bool)visit(slots[0]) : walk_ops(visit);
+        radix = OPS;
+        return stop;
+    }
+
+    //calls visit(value) for every expression over numbers[0..n), 1 <= n <= MAX_LEAVES, until
+    //visit returns true. while visit runs, describe() formats the current expression
+    template<class Visit>
+    bool for_each_expression(const double* numbers, int n, Visit&& visit){
+        if(n < 1 || n > MAX_LEAVES) return false;
+        leaves = n;
+        radix = OPS;
+        distinct_count = 0;
+        for(int i = 0; i < n; i++)
+            if(std::find(distinct, distinct + distinct_count, numbers[i]) == distinct + distinct_count) distinct[distinct_count++] = numbers[i];
+        size_t orders = 1;
+        for(int i = 2; i <= n; i++) orders *= i;
+        for(seen_mask = 1; seen_mask < 2 * orders; seen_mask <<= 1){}
+        seen_mask--;
+        const std::vector<Shape>& all = shapes_for(n);
+        for(size_t s = 0; s < all.size(); s++){
+            shape = &all[s];
+            if(distinct_count < n) std::fill(seen.begin(), seen.begin() + seen_mask + 1, 0);
+            reset_ops();
+            std::copy(numbers, numbers + n, leaf_values);
+            auto visit_order = [&](){
+                if(!first_visit()) return false;
+                std::copy(leaf_values, leaf_values + n, slots);
+                if(n == 1) return (bool)visit(slots[0]);
+                return walk_ops(visit);
+            };
+            if(visit_order()) return true;
+            //heap's algorithm, iterative: every further order is one swap from the last
+            int c[MAX_LEAVES] = {};
+            for(int i = 1; i < n;){
+                if(c[i] < i){
+                    std::swap(leaf_values[i % 2 ? c[i] : 0], leaf_values[i]);
+                    if(visit_order()) return true;
+                    c[i]++;
+                    i = 1;
+                }
+                else c[i++] = 0;
+            }
+        }
+        return false;
+    }
+
+    //the expression being visited, e.g. "(8 / (3 - (8 / 3)))" without the outer parentheses
+    std::string describe() const {
+        const char symbols[] = "+-*/-/";
+        std::string text[2 * MAX_LEAVES - 1];
+        for(int i = 0; i < leaves; i++){
+            char number[32];
+            std::snprintf(number, sizeof(number), "%g", slots[i]);
+            text[i] = number;
+        }
+        if(leaves == 1) return text[0];
+        for(int k = 0; k < leaves - 1; k++)
+            text[leaves + k] = ops[k] < OPS ? "(" + text[shape->left[k]] + " " + symbols[ops[k]] + " " + text[shape->right[k]] + ")"
+                                            : "(" + text[shape->right[k]] + " " + symbols[ops[k]] + " " + text[shape->left[k]] + ")";
+        const std::string& root = text[2 * leaves - 2];
+        return root.substr(1, root.size() - 2);
+    }
+
+    //number of expressions over numbers equal to target
+    long long count(const double* numbers, int n, double target){
+        long long hits = 0;
+        for_each_expression(numbers, n, [&](double value){
+            hits += std::fabs(value - target) < 1e-8;
+            return false;
+        });
+        return hits;
+    }
+};
+
+}
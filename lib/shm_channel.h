@@ -0,0 +1,240 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+//request/response channel over one shared-memory file (e.g. /dev/shm/solve24).
+//the layout is fixed and little-endian so any process can map it, src/shm_client.py
+//included: a 64-byte header, then slot_count slots of 192 bytes. every client owns
+//one slot; requests and answers are written in place, never serialised or copied.
+//
+//header   0 magic "S24C"   4 version   8 slot_count   12 slot_size
+//        16 doorbell (bumped per request)   20 server_sleeping
+//slot     0 state   4 kind   8 count   12 client_waiting   16 target (double)
+//        24 numbers (8 x int32)   56 result (int32)   60 text_length   64 text (128 bytes)
+//
+//slot state goes free -> request (client) -> response (server) -> free (client).
+//both sides spin briefly and then sleep on a futex (plain polling off linux), and
+//only make the wake syscall when the other side has said it is asleep
+namespace shm{
+
+const uint32_t MAGIC = 0x43343253; //"S24C"
+const uint32_t VERSION = 1;
+const uint32_t SLOT_SIZE = 192;
+const uint32_t MAX_NUMBERS = 8;
+const uint32_t TEXT_BYTES = 128;
+
+enum SlotState : uint32_t { slot_free = 0, slot_request = 1, slot_response = 2 };
+enum RequestKind : uint32_t { kind_exists = 0, kind_hint = 1 };
+
+struct Header{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;
+    uint32_t doorbell;
+    uint32_t server_sleeping;
+    uint8_t reserved[40];
+};
+
+struct Slot{
+    uint32_t state;
+    uint32_t kind;
+    uint32_t count;
+    uint32_t client_waiting;
+    double target;
+    int32_t numbers[MAX_NUMBERS];
+    int32_t result;
+    uint32_t text_length;
+    char text[TEXT_BYTES];
+};
+
+static_assert(sizeof(Header) == 64, "channel header layout");
+static_assert(sizeof(Slot) == SLOT_SIZE, "channel slot layout");
+static_assert(offsetof(Slot, numbers) == 24 && offsetof(Slot, text) == 64, "channel slot layout");
+
+inline uint32_t load(const uint32_t* word){ return __atomic_load_n(word, __ATOMIC_SEQ_CST); }
+inline void store(uint32_t* word, uint32_t value){ __atomic_store_n(word, value, __ATOMIC_SEQ_CST); }
+
+//sleeps while *word == expected, for at most timeout_us
+inline void wait_on(uint32_t* word, uint32_t expected, long timeout_us){
+#ifdef __linux__
+    timespec timeout = {timeout_us / 1000000, (timeout_us % 1000000) * 1000};
+    syscall(SYS_futex, word, FUTEX_WAIT, expected, &timeout, nullptr, 0);
+#else
+    (void)timeout_us;
+    if(load(word) == expected) std::this_thread::yield();
+#endif
+}
+
+inline void wake(uint32_t* word){
+#ifdef __linux__
+    syscall(SYS_futex, word, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+//posts a request: bumps the doorbell atomically and, only if the server said it is asleep,
+//wakes it. the seq_cst add orders the bump before the server_sleeping load, pairing with the
+//server's store of server_sleeping before it re-reads the doorbell
+inline void ring(Header* h){
+    __atomic_add_fetch(&h->doorbell, 1, __ATOMIC_SEQ_CST);
+    if(load(&h->server_sleeping)) wake(&h->doorbell);
+}
+
+//spinning only pays when the other side runs on another core at the same time
+inline int spin_rounds(){
+    static const int rounds = std::thread::hardware_concurrency() > 1 ? 2000 : 0;
+    return rounds;
+}
+
+//the mapped file; the server creates it, clients open it
+class Channel{
+private:
+    void* base;
+    size_t length;
+    std::string path;
+    bool owner;
+public:
+    Channel() : base(nullptr), length(0), owner(false) {}
+    ~Channel(){ close(); }
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    bool create(const std::string& arg1, uint32_t slots){
+#ifndef _WIN32
+        close();
+        int fd = ::open(arg1.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if(fd < 0) return false;
+        size_t bytes = sizeof(Header) + (size_t)slots * SLOT_SIZE;
+        if(ftruncate(fd, (off_t)bytes) != 0){ ::close(fd); return false; }
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(p == MAP_FAILED) return false;
+        base = p;
+        length = bytes;
+        path = arg1;
+        owner = true;
+        std::memset(base, 0, bytes);
+        header()->version = VERSION;
+        header()->slot_count = slots;
+        header()->slot_size = SLOT_SIZE;
+        store(&header()->magic, MAGIC);
+        return true;
+#else
+        (void)arg1; (void)slots;
+        return false;
+#endif
+    }
+    bool open(const std::string& arg1){
+#ifndef _WIN32
+        close();
+        int fd = ::open(arg1.c_str(), O_RDWR);
+        if(fd < 0) return false;
+        struct stat st;
+        if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)){ ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(p == MAP_FAILED) return false;
+        base = p;
+        length = (size_t)st.st_size;
+        path = arg1;
+        Header* h = header();
+        if(load(&h->magic) != MAGIC || h->version != VERSION || h->slot_size != SLOT_SIZE
+           || sizeof(Header) + (size_t)h->slot_count * SLOT_SIZE > length){
+            close();
+            return false;
+        }
+        return true;
+#else
+        (void)arg1;
+        return false;
+#endif
+    }
+    void close(){
+#ifndef _WIN32
+        if(base) munmap(base, length);
+        if(owner) unlink(path.c_str());
+#endif
+        base = nullptr;
+        length = 0;
+        owner = false;
+    }
+    bool is_open() const { return base != nullptr; }
+    Header* header() const { return (Header*)base; }
+    uint32_t slot_count() const { return base ? header()->slot_count : 0; }
+    Slot* slot(uint32_t i) const { return (Slot*)((char*)base + sizeof(Header) + (size_t)i * SLOT_SIZE); }
+
+    //answers requests until stop is set; handle fills in result and text of the slot it is given
+    void serve(const std::function<void(Slot&)>& handle, const std::atomic<bool>& stop){
+        Header* h = header();
+        int idle = 0;
+        while(!stop.load()){
+            //read the doorbell before scanning, so a request landing mid-scan still wakes us below
+            uint32_t seen = load(&h->doorbell);
+            bool any = false;
+            for(uint32_t i = 0; i < h->slot_count; i++){
+                Slot* s = slot(i);
+                if(load(&s->state) != slot_request) continue;
+                handle(*s);
+                store(&s->state, slot_response);
+                if(load(&s->client_waiting)) wake(&s->state);
+                any = true;
+            }
+            if(any){ idle = 0; continue; }
+            if(++idle < spin_rounds()) continue;
+            //clients without atomics (shm_client.py without libsolve24) bump the doorbell with a
+            //plain read-modify-write and no fence, so after saying we sleep look at the slots
+            //too, not just the doorbell. a request that still slips past is picked up when the
+            //100 ms wait times out
+            store(&h->server_sleeping, 1);
+            bool pending = load(&h->doorbell) != seen;
+            for(uint32_t i = 0; i < h->slot_count && !pending; i++) pending = load(&slot(i)->state) == slot_request;
+            if(!pending) wait_on(&h->doorbell, seen, 100000);
+            store(&h->server_sleeping, 0);
+        }
+    }
+};
+
+//one client's side of a slot: fill in the request with request(), then call()
+class Client{
+private:
+    Channel& channel;
+    Slot* mine;
+public:
+    Client(Channel& arg1, uint32_t slot_index) : channel(arg1), mine(arg1.slot(slot_index)) {}
+
+    Slot& request(){ return *mine; }
+
+    //posts the request sitting in the slot and waits for the answer, which stays in the slot
+    void call(){
+        Header* h = channel.header();
+        store(&mine->state, slot_request);
+        ring(h);
+        for(int spin = 0; load(&mine->state) != slot_response; spin++){
+            if(spin < spin_rounds()) continue;
+            store(&mine->client_waiting, 1);
+            wait_on(&mine->state, slot_request, 100000);
+            store(&mine->client_waiting, 0);
+        }
+    }
+    void release(){ store(&mine->state, slot_free); }
+};
+
+}
@@ -0,0 +1,795 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bloom_filter.h"
+#include "checkpoint.h"
+#include "memory_budget.h"
+#include "metrics.h"
+#include "rational.h"
+#include "spill.h"
+#include "transposition_cache.h"
+
+//the solver engine, header-only: include this to use Solution directly, or link
+//solve24_c.cpp and go through the C interface in solve24_c.h
+class Solution{
+private:
+    std::vector<std::vector<std::string>> solutions;
+    std::vector<std::string> first_solution;
+    int max_generated;
+    TranspositionCache* cache;
+    const SolvableFilter* filter;
+    bool verbose;
+    bool count_only;
+    bool truncated;
+    long long solution_count;
+    uint64_t nodes;
+    uint64_t cache_hits_before;
+    uint64_t cache_misses_before;
+    MemoryBudget budget;
+    OverflowPolicy overflow_policy;
+    QueryStats stats;
+    std::string spill_directory;
+    std::unique_ptr<SpillWriter> spill;
+    //the hand as doubles when it has a fraction; empty for all-int hands, which stay in numbers
+    std::vector<double> fractional;
+    //one level of the full-solution search: the values left and the next step to try there,
+    //pair (i, j) and op 0-5 in the order + * - / on (i, j), then - / on (j, i)
+    struct SearchFrame{
+        std::vector<double> nums;
+        int i;
+        int j;
+        int op;
+    };
+    //frames[0..depth) is the search stack; frames past depth keep their buffers for reuse
+    std::vector<SearchFrame> frames;
+    size_t depth;
+    std::string checkpoint_path;
+    double checkpoint_interval;
+    bool interrupted;
+    //checkpoint_on_disk: the file at checkpoint_path holds some state of this search (saved, or
+    //resumed from); checkpoint_current: the last save succeeded
+    bool checkpoint_on_disk;
+    bool checkpoint_current;
+    int checkpoint_failures;
+public:
+    //the hand when every number is an int; empty for a hand with a fraction (see from_rationals)
+    std::vector<int> numbers;
+    double target;
+    Solution(std::vector<int> arg1){
+        numbers = arg1;
+        target = 24;
+        max_generated = 1024;
+        cache = nullptr;
+        filter = nullptr;
+        verbose = true;
+        count_only = false;
+        truncated = false;
+        solution_count = 0;
+        nodes = 0;
+        overflow_policy = OverflowPolicy::truncate;
+        spill_directory = ".";
+        depth = 0;
+        checkpoint_interval = 0;
+        interrupted = false;
+        checkpoint_on_disk = false;
+        checkpoint_current = false;
+        checkpoint_failures = 0;
+    }
+    Solution(std::vector<int> arg1, double arg2){
+        numbers = arg1;
+        target = arg2;
+        max_generated = 1024;
+        cache = nullptr;
+        filter = nullptr;
+        verbose = true;
+        count_only = false;
+        truncated = false;
+        solution_count = 0;
+        nodes = 0;
+        overflow_policy = OverflowPolicy::truncate;
+        spill_directory = ".";
+        depth = 0;
+        checkpoint_interval = 0;
+        interrupted = false;
+        checkpoint_on_disk = false;
+        checkpoint_current = false;
+        checkpoint_failures = 0;
+    }
+    Solution(std::vector<int> arg1, double arg2, int arg3){
+        numbers = arg1;
+        target = arg2;
+        max_generated = arg3;
+        cache = nullptr;
+        filter = nullptr;
+        verbose = true;
+        count_only = false;
+        truncated = false;
+        solution_count = 0;
+        nodes = 0;
+        overflow_policy = OverflowPolicy::truncate;
+        spill_directory = ".";
+        depth = 0;
+        checkpoint_interval = 0;
+        interrupted = false;
+        checkpoint_on_disk = false;
+        checkpoint_current = false;
+        checkpoint_failures = 0;
+    }
+    //fractions and decimals (see parse_rational). a hand of ints is kept in numbers as the
+    //int constructors keep it, so it gets the filter and loses nothing; a hand with a fraction
+    //leaves numbers empty and is searched from get_values(), which are doubles: unlike
+    //Solver's Rational overloads this search is not exact, and a result within 1e-8 of target
+    //counts. a factory rather than a constructor, so a braced list like
+    //Solution({1, 3, 4, 6}, 36) still means the int hand
+    static Solution from_rationals(const std::vector<Rational>& hand, double target){
+        Solution solution(std::vector<int>(), target);
+        for(size_t i = 0; i < hand.size(); i++){
+            if(hand[i].is_integer() && hand[i].num <= INT32_MAX && hand[i].num >= INT32_MIN) solution.numbers.push_back((int)hand[i].num);
+            solution.fractional.push_back(hand[i].to_double());
+        }
+        if(solution.numbers.size() == hand.size()) solution.fractional.clear();
+        else solution.numbers.clear();
+        return solution;
+    }
+    //the hand as the search sees it, fractions included (numbers is empty for those)
+    std::vector<double> get_values() const {
+        return start_values();
+    }
+    std::vector<std::vector<std::string>> get_all_solutions(){
+        return solutions;
+    }
+    std::vector<std::string> get_first_solution(){
+        return first_solution;
+    }
+    int get_max_generated(){
+        return max_generated;
+    }
+    void set_max_generated(int arg1){
+        max_generated = arg1;
+    }
+    //shared memo for is_valid_input; not owned, may be reused across instances
+    void set_cache(TranspositionCache* arg1){
+        cache = arg1;
+    }
+    //checked before solution_exists: a miss in the filter is a definite "unsolvable"; not owned
+    void set_filter(const SolvableFilter* arg1){
+        filter = arg1;
+    }
+    //find_first_solution prints the solution it finds unless verbose is off
+    void set_verbose(bool arg1){
+        verbose = arg1;
+    }
+    //caps the bytes one query may hold in stored solutions and search scratch (0 = no cap).
+    //past the cap find_all_solutions keeps counting but either stops storing (truncate)
+    //or drops what it stored and reports only the count (count_only)
+    //or moves everything to a sorted, deduplicated file on disk (spill, see set_spill_directory).
+    //with spill, max_generated also only bounds what is kept in memory
+    void set_memory_cap(size_t bytes, OverflowPolicy policy){
+        budget.set_cap(bytes);
+        overflow_policy = policy;
+    }
+    //where spilled runs and the final result file go; the file name is in get_query_stats().spill_path
+    void set_spill_directory(std::string arg1){
+        spill_directory = arg1;
+    }
+    //find_all_solutions saves its search to path every interval seconds (0: never on a timer)
+    //and whenever checkpoint::stop_requested is set, e.g. by a SIGTERM handler, after which it
+    //stops. the file is removed once a search completes; an empty path turns this off
+    void set_checkpoint(std::string arg1, double arg2){
+        checkpoint_path = arg1;
+        checkpoint_interval = arg2;
+    }
+    //true when the last find_all_solutions or resume_all_solutions stopped at a checkpoint
+    bool is_interrupted(){
+        return interrupted;
+    }
+    //true when it stopped and the checkpoint it saved on the way out was written, so it can be
+    //resumed from there. a failed write is reported on stderr; a timed one leaves the search
+    //running, and one on a stop request leaves an interrupted search that is not resumable
+    bool is_resumable(){
+        return interrupted && checkpoint_current;
+    }
+    //checkpoint writes that failed during the last find_all_solutions or resume_all_solutions
+    int get_checkpoint_failures(){
+        return checkpoint_failures;
+    }
+    //high-water mark, degradation and counts of the last query
+    QueryStats get_query_stats(){
+        return stats;
+    }
+    //true when the last find_all_solutions dropped solutions past max_generated or the memory cap
+    bool is_truncated(){
+        return truncated;
+    }
+    long long get_solution_count(){
+        return solution_count;
+    }
+    uint64_t get_nodes_searched(){
+        return nodes;
+    }
+public:
+    bool is_valid_input(){
+        std::chrono::steady_clock::time_point start = begin_query();
+        bool found = false;
+        if(!filter || !fractional.empty() || !filter->rejects(numbers, target)){
+            std::vector<double> values = start_values();
+            found = solution_exists(values, target);
+        }
+        end_query(SolveMode::exists, start);
+        return found;
+    } 
+    bool find_first_solution(){
+        std::chrono::steady_clock::time_point start = begin_query();
+        std::vector<double> values = start_values();
+        std::vector<std::string> output;
+        bool found = solve_first(values, output, target);
+        solution_count = found ? 1 : 0;
+        end_query(SolveMode::first, start);
+        return found;
+    }
+    void find_all_solutions(){
+        std::chrono::steady_clock::time_point start = begin_query();
+        std::vector<std::vector<std::string>>().swap(solutions);
+        start_walk();
+        checkpoint_on_disk = false;
+        finish_all(walk_all(true), start);
+    }
+    //continues the search a checkpoint saved, exactly where it stopped: solutions found before
+    //it are kept (in memory or in its spill runs) and none is found twice. this Solution must
+    //have the same hand, target and max_generated; false, with nothing run, if the file is
+    //missing, malformed or for another query. checkpoints go to set_checkpoint's path
+    bool resume_all_solutions(const std::string& path){
+        std::string bytes;
+        if(!checkpoint::read_file(path, bytes)) return false;
+        std::chrono::steady_clock::time_point start = begin_query();
+        if(!load_checkpoint(bytes)){
+            std::vector<std::vector<std::string>>().swap(solutions);
+            depth = 0;
+            spill.reset();
+            count_only = false;
+            return false;
+        }
+        checkpoint_on_disk = path == checkpoint_path;
+        finish_all(walk_all(true), start);
+        return true;
+    }
+    //number of solutions find_all_solutions would generate, without storing any
+    long long count_solutions(){
+        std::chrono::steady_clock::time_point start = begin_query();
+        count_only = true;
+        start_walk();
+        walk_all(false);
+        count_only = false;
+        stats.count_only = true;
+        end_query(SolveMode::count, start);
+        return solution_count;
+    }
+    void print_solutions(){
+        for(int i = 0; i < solutions.size(); i++){
+            std::cout << "Solution:" << std::endl;
+            print_output_cpp(solutions[i]);
+        }
+    }
+private:
+    std::vector<double> start_values() const {
+        return fractional.empty() ? std::vector<double>(numbers.begin(), numbers.end()) : fractional;
+    }
+    std::chrono::steady_clock::time_point begin_query(){
+        interrupted = false;
+        checkpoint_current = false;
+        checkpoint_failures = 0;
+        truncated = false;
+        solution_count = 0;
+        nodes = 0;
+        budget.reset();
+        stats = QueryStats();
+        cache_hits_before = cache ? cache->get_hits() : 0;
+        cache_misses_before = cache ? cache->get_misses() : 0;
+        return std::chrono::steady_clock::now();
+    }
+    void end_query(SolveMode mode, std::chrono::steady_clock::time_point start){
+        MetricsRegistry& registry = metrics();
+        registry.record_request(mode, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        registry.add(Counter::nodes, nodes);
+        registry.add(Counter::solutions, (uint64_t)solution_count);
+        if(truncated) registry.add(Counter::truncations, 1);
+        if(cache){
+            registry.add(Counter::cache_hits, cache->get_hits() - cache_hits_before);
+            registry.add(Counter::cache_misses, cache->get_misses() - cache_misses_before);
+        }
+        stats.high_water_bytes = budget.get_high_water();
+        stats.cap_bytes = budget.get_cap();
+        stats.cache_bytes = cache ? cache->get_bytes() : 0;
+        stats.truncated = truncated;
+        stats.solution_count = solution_count;
+        stats.nodes = nodes;
+    }
+    //a solution did not fit: degrade according to the overflow policy
+    void overflow(DegradeReason reason){
+        if(overflow_policy == OverflowPolicy::spill){
+            start_spill(reason);
+            return;
+        }
+        truncated = true;
+        if(stats.reason == DegradeReason::none) stats.reason = reason;
+        if(reason == DegradeReason::memory_cap && overflow_policy == OverflowPolicy::count_only){
+            budget.release(stats.solution_bytes);
+            stats.solution_bytes = 0;
+            std::vector<std::vector<std::string>>().swap(solutions);
+            count_only = true;
+        }
+    }
+    //moves the stored solutions to a SpillWriter; every later solution goes straight to it
+    void start_spill(DegradeReason reason){
+        //replay --threads runs a Solution per thread: the counter keeps names apart within one clock tick
+        static std::atomic<int> spill_counter(0);
+        std::string name = "solve24-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "-" + std::to_string(spill_counter.fetch_add(1));
+        size_t buffer = budget.get_cap() ? std::max((size_t)4096, budget.get_cap() / 4) : (size_t)64 * 1024 * 1024;
+        spill.reset(new SpillWriter(spill_directory, name, buffer));
+        stats.spilled = true;
+        stats.reason = reason;
+        stats.spill_path = spill_directory + "/" + name + ".txt";
+        for(size_t i = 0; i < solutions.size(); i++) spill_solution(solutions[i]);
+        std::vector<std::vector<std::string>>().swap(solutions);
+        budget.release(stats.solution_bytes);
+        stats.solution_bytes = 0;
+        budget.force(buffer);
+    }
+    //after the first failed write nothing more is spilled; the search still counts
+    void spill_solution(const std::vector<std::string>& steps){
+        if(!stats.spill_failed && !spill->add(encode_solution(steps))) stats.spill_failed = true;
+    }
+    static size_t frame_bytes(const std::vector<double>& nums, const std::vector<std::string>& prev_ops){
+        //the frame holds prev_ops, its working copy and the reduced value vector
+        return 2 * steps_bytes(prev_ops) + (nums.size() + 1) * sizeof(double);
+    }
+private: 
+    void print_output_cpp(std::vector<std::string> output){
+        for(int i = 0; i < output.size(); i++) 
+            std::cout << output[i] << std::endl;
+    }
+private:
+    bool solution_exists(std::vector<double>& nums, double target){
+        nodes++;
+        if(nums.size() == 1){
+            return std::fabs(nums[0] - target) < 1e-8;
+        }
+        if(cache == nullptr || nums.size() < 3){
+            return expand_exists(nums, target);
+        }
+        uint64_t key = TranspositionCache::fingerprint(nums, target);
+        bool found;
+        if(cache->lookup(key, found)){
+            return found;
+        }
+        found = expand_exists(nums, target);
+        cache->store(key, found);
+        return found;
+    }
+    bool expand_exists(std::vector<double>& nums, double target){
+        ScratchCharge frame(budget, nums.size() * sizeof(double));
+        double val;
+        for(int i = 0; i + 1 < nums.size(); ++i){
+            for(int j = i + 1; j < nums.size(); ++j){
+                std::vector<double> new_nums;
+                for(int k = 0; k < nums.size(); ++k)
+                    if(k != i && k != j) new_nums.push_back(nums[k]);
+                std::string val1 = std::to_string(nums[i]);
+                std::string val2 = std::to_string(nums[j]); 
+                //addition i, j
+                val = nums[i] + nums[j];
+                new_nums.push_back(val);
+                if(solution_exists(new_nums, target)){
+                    return true;
+                }
+                val = nums[i] * nums[j];
+                new_nums.back() = val;
+                if(solution_exists(new_nums, target)){
+                    return true;
+                }
+                //subtraction i, j
+                val = nums[i] - nums[j];
+                new_nums.back() = val;
+                if(solution_exists(new_nums, target)){
+                    return true;
+                }
+                //division i, j
+                val = nums[i] / nums[j];
+                new_nums.back() = val;
+                if(solution_exists(new_nums, target)){
+                    return true;
+                }
+                //subtraction j, i
+                val = nums[j] - nums[i];
+                new_nums.back() = val;
+                if(solution_exists(new_nums, target)){
+                    return true;
+                }
+                //division j, i
+                val = nums[j] / nums[i];
+                new_nums.back() = val;
+                if(solution_exists(new_nums, target)){
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    bool solve_first(std::vector<double>& nums, std::vector<std::string> prev_ops, double target){
+        nodes++;
+        if(nums.size() == 1){
+            if(std::fabs(nums[0] - target) < 1e-8){
+                if(verbose) print_output_cpp(prev_ops);
+                stats.solution_bytes = steps_bytes(prev_ops);
+                budget.force(stats.solution_bytes);
+                first_solution = prev_ops;
+                return true;
+            }
+            return false;
+        }
+        ScratchCharge frame(budget, frame_bytes(nums, prev_ops));
+        double val;
+        std::string input;
+        for(int i = 0; i + 1 < nums.size(); ++i){
+            for(int j = i + 1; j < nums.size(); ++j){
+                std::vector<std::string> output;
+                output = prev_ops;
+                std::vector<double> new_nums;
+                for(int k = 0; k < nums.size(); ++k)
+                    if(k != i && k != j) new_nums.push_back(nums[k]);
+                std::string val1 = std::to_string(nums[i]);
+                std::string val2 = std::to_string(nums[j]); 
+                output.push_back(val1);
+                output.push_back(val2);
+                //addition i, j
+                val = nums[i] + nums[j];
+                input = std::to_string(val);
+                output.push_back(input);
+                output.push_back("+");
+                new_nums.push_back(val);
+                if(solve_first(new_nums, output, target)){
+                    return true;
+                }
+                output.pop_back();
+                output.pop_back();
+                val = nums[i] * nums[j];
+                input = std::to_string(val);
+                output.push_back(input);
+                output.push_back("*");
+                new_nums.back() = val;
+                if(solve_first(new_nums, output, target)){
+                    return true;
+                }
+                //subtraction i, j
+                output.pop_back();
+                output.pop_back();
+                val = nums[i] - nums[j];
+                input = std::to_string(val);
+                output.push_back(input);
+                output.push_back("-");
+                new_nums.back() = val;
+                if(solve_first(new_nums, output, target)){
+                    return true;
+                }
+                //division i, j
+                output.pop_back();
+                output.pop_back();
+                val = nums[i] / nums[j];
+                input = std::to_string(val);
+                output.push_back(std::to_string(val));
+                output.push_back("/");
+                new_nums.back() = val;
+                if(solve_first(new_nums, output, target)){
+                    return true;
+                }
+                output.pop_back();
+                output.pop_back();
+                output.pop_back();
+                output.pop_back();
+                output.push_back(val2);
+                output.push_back(val1);
+                //subtraction j, i
+                val = nums[j] - nums[i];
+                input = std::to_string(val);
+                output.push_back(input);
+                output.push_back("-");
+                new_nums.back() = val;
+                if(solve_first(new_nums, output, target)){
+                    return true;
+                }
+                //division j, i
+                output.pop_back();
+                output.pop_back();
+                val = nums[j] / nums[i];
+                input = std::to_string(val);
+                output.push_back(input);
+                output.push_back("/");
+                new_nums.back() = val;
+                if(solve_first(new_nums, output, target)){
+                    return true;
+                }
+                output.pop_back();
+                output.pop_back();
+                output.pop_back();
+                output.pop_back();
+            }
+        }
+        return false;
+    }
+    static double apply_step(double a, double b, int op){
+        switch(op){
+            case 0: return a + b;
+            case 1: return a * b;
+            case 2: return a - b;
+            case 3: return a / b;
+            case 4: return b - a;
+            default: return b / a;
+        }
+    }
+    static size_t frame_bytes(const SearchFrame& frame){
+        return sizeof(SearchFrame) + frame.nums.size() * sizeof(double);
+    }
+    //pushes the frame that step op of (i, j) in the top frame leads to
+    void push_frame(int i, int j, int op){
+        if(frames.size() <= depth) frames.resize(depth + 1);
+        SearchFrame& child = frames[depth];
+        const SearchFrame& parent = frames[depth - 1];
+        child.nums.clear();
+        for(int k = 0; k < (int)parent.nums.size(); k++)
+            if(k != i && k != j) child.nums.push_back(parent.nums[k]);
+        child.nums.push_back(apply_step(parent.nums[i], parent.nums[j], op));
+        enter_frame();
+    }
+    void enter_frame(){
+        SearchFrame& frame = frames[depth++];
+        frame.i = 0;
+        frame.j = 1;
+        frame.op = 0;
+        nodes++;
+        if(frame.nums.size() > 1) budget.force(frame_bytes(frame));
+    }
+    void pop_frame(){
+        SearchFrame& frame = frames[--depth];
+        if(frame.nums.size() > 1) budget.release(frame_bytes(frame));
+    }
+    void start_walk(){
+        if(frames.empty()) frames.resize(1);
+        frames[0].nums = start_values();
+        depth = 0;
+        enter_frame();
+    }
+    //the four strings per step of the path to the top frame, as get_first_solution gives them
+    std::vector<std::string> path_steps() const {
+        std::vector<std::string> steps;
+        for(size_t d = 0; d + 1 < depth; d++){
+            const SearchFrame& f = frames[d];
+            int op = f.op - 1;
+            double a = f.nums[f.i], b = f.nums[f.j];
+            steps.push_back(std::to_string(op < 4 ? a : b));
+            steps.push_back(std::to_string(op < 4 ? b : a));
+            steps.push_back(std::to_string(apply_step(a, b, op)));
+            steps.push_back(std::string(1, "+*-/-/"[op]));
+        }
+        return steps;
+    }
+    void record_solution(){
+        solution_count++;
+        if(count_only){
+            return;
+        }
+        std::vector<std::string> steps = path_steps();
+        if(spill){
+            spill_solution(steps);
+            return;
+        }
+        if((int)solutions.size() >= max_generated){
+            overflow(DegradeReason::max_generated);
+            return;
+        }
+        size_t bytes = steps_bytes(steps) + sizeof(std::vector<std::string>);
+        if(!budget.charge(bytes)){
+            overflow(DegradeReason::memory_cap);
+            return;
+        }
+        stats.solution_bytes += bytes;
+        solutions.push_back(steps);
+    }
+    //the full-solution search as a loop over an explicit stack, in the same order as the
+    //pairwise recursion of solve_first; its whole state is the frames' cursors, which is what
+    //makes it checkpointable. returns false when it stopped at a checkpoint
+    bool walk_all(bool checkpoints){
+        checkpoints = checkpoints && !checkpoint_path.empty();
+        std::chrono::steady_clock::time_point last_save = std::chrono::steady_clock::now();
+        uint64_t steps = 0;
+        while(depth > 0){
+            if(checkpoints && (checkpoint::stop_requested || (checkpoint_interval > 0 && (++steps & 4095) == 0
+                && std::chrono::duration<double>(std::chrono::steady_clock::now() - last_save).count() >= checkpoint_interval))){
+                checkpoint_current = save_checkpoint();
+                if(checkpoint_current) checkpoint_on_disk = true;
+                else{
+                    checkpoint_failures++;
+                    std::cerr << "could not write checkpoint " << checkpoint_path
+                              << (checkpoint::stop_requested ? "; stopping without a resumable state" : "; still searching") << std::endl;
+                }
+                last_save = std::chrono::steady_clock::now();
+                if(checkpoint::stop_requested) return false;
+            }
+            SearchFrame& f = frames[depth - 1];
+            int m = (int)f.nums.size();
+            if(m == 1){
+                if(std::fabs(f.nums[0] - target) < 1e-8) record_solution();
+                pop_frame();
+                continue;
+            }
+            if(f.op == 6){
+                f.op = 0;
+                if(++f.j == m){
+                    f.i++;
+                    f.j = f.i + 1;
+                }
+            }
+            if(f.j >= m){
+                pop_frame();
+                continue;
+            }
+            int op = f.op++;
+            push_frame(f.i, f.j, op);
+        }
+        return true;
+    }
+    void finish_all(bool completed, std::chrono::steady_clock::time_point start){
+        stats.count_only = count_only;
+        count_only = false;
+        if(!completed){
+            interrupted = true;
+            //the runs belong to the checkpoint now, or to an older one of this search when the
+            //last write failed; with neither they are removed
+            if(spill && checkpoint_on_disk) spill->detach();
+            spill.reset();
+        }
+        else{
+            if(spill){
+                long long count = stats.spill_failed ? -1 : spill->finish(stats.spill_path);
+                stats.spill_failed = count < 0;
+                stats.spilled_solutions = std::max(count, 0LL);
+                if(stats.spill_failed) std::remove(stats.spill_path.c_str());
+                spill.reset();
+            }
+            if(!checkpoint_path.empty()) std::remove(checkpoint_path.c_str());
+        }
+        end_query(SolveMode::all, start);
+    }
+    //"S24K", the query (hand, target, max_generated), counters and degradation state, the
+    //stack as (i, j, op) per frame, the stored solutions, and the spill writer if one is open.
+    //frame values are not saved: replaying the cursors from the hand rebuilds them bit for bit
+    bool save_checkpoint(){
+        std::string out("S24K");
+        std::vector<double> hand = start_values();
+        checkpoint::put_u64(out, hand.size());
+        for(size_t i = 0; i < hand.size(); i++) checkpoint::put_double(out, hand[i]);
+        checkpoint::put_double(out, target);
+        checkpoint::put_u64(out, (uint64_t)max_generated);
+        checkpoint::put_u64(out, (uint64_t)solution_count);
+        checkpoint::put_u64(out, nodes);
+        checkpoint::put_u64(out, (truncated ? 1 : 0) | (count_only ? 2 : 0) | (spill ? 4 : 0));
+        checkpoint::put_u64(out, (uint64_t)stats.reason);
+        checkpoint::put_u64(out, depth);
+        for(size_t d = 0; d < depth; d++){
+            checkpoint::put_u64(out, (uint64_t)frames[d].i);
+            checkpoint::put_u64(out, (uint64_t)frames[d].j);
+            checkpoint::put_u64(out, (uint64_t)frames[d].op);
+        }
+        checkpoint::put_u64(out, solutions.size());
+        for(size_t i = 0; i < solutions.size(); i++) checkpoint::put_string(out, encode_solution(solutions[i]));
+        if(spill){
+            //runs that lost solutions cannot be resumed from
+            SpillState state;
+            if(stats.spill_failed || !spill->checkpoint(state)) return false;
+            checkpoint::put_string(out, stats.spill_path);
+            checkpoint::put_u64(out, spill->get_buffer_limit());
+            checkpoint::put_string(out, state.prefix);
+            checkpoint::put_u64(out, (uint64_t)state.next_run);
+            checkpoint::put_u64(out, state.written);
+            checkpoint::put_u64(out, state.runs.size());
+            for(size_t i = 0; i < state.runs.size(); i++) checkpoint::put_string(out, state.runs[i]);
+        }
+        return checkpoint::write_file(checkpoint_path, out);
+    }
+    bool load_checkpoint(const std::string& in){
+        size_t at = 4;
+        uint64_t count, value, flags, reason, saved_depth;
+        std::vector<double> hand = start_values();
+        if(in.compare(0, 4, "S24K") != 0 || !checkpoint::get_u64(in, at, count) || count != hand.size()) return false;
+        for(size_t i = 0; i < hand.size(); i++){
+            double v;
+            if(!checkpoint::get_double(in, at, v) || std::memcmp(&v, &hand[i], sizeof(v)) != 0) return false;
+        }
+        double saved_target;
+        if(!checkpoint::get_double(in, at, saved_target) || std::memcmp(&saved_target, &target, sizeof(target)) != 0) return false;
+        if(!checkpoint::get_u64(in, at, value) || value != (uint64_t)max_generated) return false;
+        if(!checkpoint::get_u64(in, at, value)) return false;
+        solution_count = (long long)value;
+        if(!checkpoint::get_u64(in, at, nodes) || !checkpoint::get_u64(in, at, flags) || !checkpoint::get_u64(in, at, reason)) return false;
+        if(!checkpoint::get_u64(in, at, saved_depth) || saved_depth == 0 || saved_depth > hand.size()) return false;
+        truncated = flags & 1;
+        count_only = (flags & 2) != 0;
+        stats.reason = (DegradeReason)reason;
+        //rebuild the stack: each frame below the top made its child with step op - 1
+        uint64_t saved_nodes = nodes;
+        start_walk();
+        for(size_t d = 0; d < saved_depth; d++){
+            uint64_t i, j, op;
+            if(!checkpoint::get_u64(in, at, i) || !checkpoint::get_u64(in, at, j) || !checkpoint::get_u64(in, at, op)) return false;
+            SearchFrame& f = frames[d];
+            bool top = d + 1 == saved_depth;
+            if(i >= f.nums.size() || j <= i || j > f.nums.size() || op > 6 || (!top && (op == 0 || j == f.nums.size()))) return false;
+            f.i = (int)i;
+            f.j = (int)j;
+            f.op = (int)op;
+            if(!top) push_frame(f.i, f.j, f.op - 1);
+        }
+        nodes = saved_nodes;
+        if(!checkpoint::get_u64(in, at, count) || count > in.size()) return false;
+        std::vector<std::vector<std::string>>().swap(solutions);
+        for(uint64_t k = 0; k < count; k++){
+            std::string line;
+            if(!checkpoint::get_string(in, at, line)) return false;
+            solutions.push_back(decode_solution(line.data(), line.size()));
+            size_t bytes = steps_bytes(solutions.back()) + sizeof(std::vector<std::string>);
+            budget.force(bytes);
+            stats.solution_bytes += bytes;
+        }
+        if(flags & 4){
+            SpillState state;
+            uint64_t buffer, next_run, runs;
+            if(!checkpoint::get_string(in, at, stats.spill_path) || !checkpoint::get_u64(in, at, buffer)
+               || !checkpoint::get_string(in, at, state.prefix) || !checkpoint::get_u64(in, at, next_run)
+               || !checkpoint::get_u64(in, at, state.written) || !checkpoint::get_u64(in, at, runs) || runs > in.size()) return false;
+            state.next_run = (int)next_run;
+            for(uint64_t k = 0; k < runs; k++){
+                std::string run;
+                if(!checkpoint::get_string(in, at, run)) return false;
+                state.runs.push_back(run);
+            }
+            spill.reset(new SpillWriter(spill_directory, state, (size_t)buffer));
+            stats.spilled = true;
+            budget.force((size_t)buffer);
+        }
+        return at == in.size();
+    }
+};
+
+//compile-time hand size: the same search as Solution::is_valid_input with the
+//recursion unrolled over N and every value array on the stack. no cache, metrics
+//or memory accounting, for callers that want the smallest possible inner loop
+template<size_t N>
+inline bool solvable_fixed(const std::array<double, N>& nums, double target){
+    std::array<double, N - 1> next;
+    for(size_t i = 0; i + 1 < N; i++){
+        for(size_t j = i + 1; j < N; j++){
+            size_t n = 0;
+            for(size_t k = 0; k < N; k++)
+                if(k != i && k != j) next[n++] = nums[k];
+            double a = nums[i], b = nums[j];
+            double results[6] = {a + b, a * b, a - b, b - a, a / b, b / a};
+            for(int r = 0; r < 6; r++){
+                next[N - 2] = results[r];
+                if(solvable_fixed<N - 1>(next, target)) return true;
+            }
+        }
+    }
+    return false;
+}
+
+template<>
+inline bool solvable_fixed<1>(const std::array<double, 1>& nums, double target){
+    return std::fabs(nums[0] - target) < 1e-8;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "hand_rank.h"
+#include "huge_pages.h"
+#include "progress.h"
+#include "reachable.h"
+
+//precomputed answer to "can this hand make this target" for every hand of
+//`cards` cards from 1..max_value and every integer target in [min_target, max_target].
+//one bit per (hand rank, target), hands laid out back to back in huge-page memory
+class SolvableTable{
+private:
+    int cards;
+    int max_value;
+    long long min_target;
+    long long max_target;
+    size_t words_per_hand;
+    uint64_t hands;
+    HugePageArray<uint64_t> bits;
+public:
+    SolvableTable(int arg1, int arg2, long long arg3, long long arg4){
+        cards = arg1;
+        max_value = arg2;
+        min_target = arg3;
+        max_target = arg4;
+        words_per_hand = (size_t)((max_target - min_target) / 64 + 1);
+        hands = hand_count(cards, max_value);
+        bits.resize(hands * words_per_hand);
+    }
+    int get_cards() const { return cards; }
+    int get_max_value() const { return max_value; }
+    long long get_min_target() const { return min_target; }
+    long long get_max_target() const { return max_target; }
+    uint64_t get_hands() const { return hands; }
+    size_t get_bytes() const { return bits.bytes(); }
+    HugePageMode get_mode() const { return bits.mode(); }
+    const uint64_t* hand_bits(uint64_t rank) const { return bits.data() + rank * words_per_hand; }
+    size_t get_words_per_hand() const { return words_per_hand; }
+
+    //returns the value pairs combined, the nodes progress reports count
+    uint64_t build_hand(uint64_t rank){
+        std::vector<int> hand = unrank_hand(rank, cards, max_value);
+        return reach::mark_integer_targets(reach::to_rationals(hand), min_target, max_target, bits.data() + rank * words_per_hand);
+    }
+    //hands own disjoint words, so threads split the ranks with no further coordination;
+    //progress (optional, at least threads workers) follows the build
+    void build(int threads = 1, ProgressBoard* progress = nullptr){
+        for_each_rank(hands, threads, progress, [this](uint64_t rank){ return build_hand(rank); });
+    }
+
+    bool covers(const std::vector<int>& hand, long long target) const {
+        if((int)hand.size() != cards || target < min_target || target > max_target) return false;
+        for(size_t i = 0; i < hand.size(); i++)
+            if(hand[i] < 1 || hand[i] > max_value) return false;
+        return true;
+    }
+    bool is_solvable(uint64_t rank, long long target) const {
+        long long off = target - min_target;
+        return (bits[rank * words_per_hand + (off >> 6)] >> (off & 63)) & 1;
+    }
+    bool is_solvable(const std::vector<int>& hand, long long target) const {
+        return is_solvable(rank_hand(hand), target);
+    }
+
+    bool save(const std::string& path) const {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if(!f) return false;
+        long long header[4] = {cards, max_value, min_target, max_target};
+        bool ok = std::fwrite("S24T", 1, 4, f) == 4
+               && std::fwrite(header, sizeof(header), 1, f) == 1
+               && std::fwrite(bits.data(), sizeof(uint64_t), bits.size(), f) == bits.size();
+        return std::fclose(f) == 0 && ok;
+    }
+    //reads straight into huge-page memory; returns nullptr on a missing or malformed file
+    static SolvableTable* load(const std::string& path){
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if(!f) return nullptr;
+        char magic[4];
+        long long header[4];
+        SolvableTable* table = nullptr;
+        if(std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, "S24T", 4) == 0
+           && std::fread(header, sizeof(header), 1, f) == 1
+           && header[0] > 0 && header[0] <= 8 && header[1] > 0 && header[2] <= header[3]){
+            table = new SolvableTable((int)header[0], (int)header[1], header[2], header[3]);
+            if(std::fread(table->bits.data(), sizeof(uint64_t), table->bits.size(), f) != table->bits.size()){
+                delete table;
+                table = nullptr;
+            }
+        }
+        std::fclose(f);
+        return table;
+    }
+};
@@ -0,0 +1,114 @@
+#include <cstring>
+#include <memory>
+#include <new>
+#include <sstream>
+#include "shm_channel.h"
+#include "solution.h"
+#include "solve24_c.h"
+
+struct solve24_solver{
+    std::unique_ptr<TranspositionCache> cache;
+};
+
+//"3 * 8 = 24; ..." style, the way solve_24 channel hints print
+static std::string join_steps(const std::vector<std::string>& steps){
+    std::ostringstream out;
+    for(size_t i = 0; i + 3 < steps.size(); i += 4){
+        if(i) out << "; ";
+        out << std::atof(steps[i].c_str()) << " " << steps[i + 3] << " " << std::atof(steps[i + 1].c_str())
+            << " = " << std::atof(steps[i + 2].c_str());
+    }
+    return out.str();
+}
+
+static bool valid_hand(const int* numbers, size_t count){
+    return numbers != nullptr && count > 0 && count <= 12;
+}
+
+static Solution make_solution(solve24_solver* solver, const int* numbers, size_t count, double target){
+    Solution solution(std::vector<int>(numbers, numbers + count), target);
+    solution.set_verbose(false);
+    solution.set_cache(solver->cache.get());
+    return solution;
+}
+
+extern "C" {
+
+int solve24_abi_version(void){
+    return SOLVE24_ABI_VERSION;
+}
+
+solve24_solver* solve24_create(size_t cache_entries){
+    try{
+        std::unique_ptr<solve24_solver> solver(new solve24_solver());
+        if(cache_entries > 0) solver->cache.reset(new TranspositionCache(cache_entries));
+        return solver.release();
+    }
+    catch(...){
+        return nullptr;
+    }
+}
+
+void solve24_destroy(solve24_solver* solver){
+    delete solver;
+}
+
+int solve24_is_solvable(solve24_solver* solver, const int* numbers, size_t count, double target){
+    if(solver == nullptr || !valid_hand(numbers, count)) return SOLVE24_ERROR_ARGUMENT;
+    try{
+        Solution solution = make_solution(solver, numbers, count, target);
+        return solution.is_valid_input() ? SOLVE24_OK : SOLVE24_NO_SOLUTION;
+    }
+    catch(const std::bad_alloc&){
+        return SOLVE24_ERROR_MEMORY;
+    }
+    catch(...){
+        return SOLVE24_ERROR_INTERNAL;
+    }
+}
+
+int solve24_first_solution(solve24_solver* solver, const int* numbers, size_t count, double target,
+                           char* buffer, size_t buffer_size, size_t* needed){
+    if(solver == nullptr || !valid_hand(numbers, count) || (buffer == nullptr && buffer_size > 0)) return SOLVE24_ERROR_ARGUMENT;
+    try{
+        Solution solution = make_solution(solver, numbers, count, target);
+        if(!solution.find_first_solution()){
+            if(needed) *needed = 1;
+            if(buffer_size > 0) buffer[0] = '\0';
+            return SOLVE24_NO_SOLUTION;
+        }
+        std::string text = join_steps(solution.get_first_solution());
+        if(needed) *needed = text.size() + 1;
+        if(buffer_size < text.size() + 1) return SOLVE24_ERROR_BUFFER;
+        std::memcpy(buffer, text.c_str(), text.size() + 1);
+        return SOLVE24_OK;
+    }
+    catch(const std::bad_alloc&){
+        return SOLVE24_ERROR_MEMORY;
+    }
+    catch(...){
+        return SOLVE24_ERROR_INTERNAL;
+    }
+}
+
+int solve24_count_solutions(solve24_solver* solver, const int* numbers, size_t count, double target,
+                            long long* solutions){
+    if(solver == nullptr || !valid_hand(numbers, count) || solutions == nullptr) return SOLVE24_ERROR_ARGUMENT;
+    try{
+        Solution solution = make_solution(solver, numbers, count, target);
+        *solutions = solution.count_solutions();
+        return *solutions > 0 ? SOLVE24_OK : SOLVE24_NO_SOLUTION;
+    }
+    catch(const std::bad_alloc&){
+        return SOLVE24_ERROR_MEMORY;
+    }
+    catch(...){
+        return SOLVE24_ERROR_INTERNAL;
+    }
+}
+
+void solve24_channel_ring(void* channel){
+    if(channel != nullptr) shm::ring((shm::Header*)channel);
+}
+
+}
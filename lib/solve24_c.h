@@ -0,0 +1,66 @@
+#ifndef SOLVE24_C_H
+#define SOLVE24_C_H
+#include <stddef.h>
+
+/* stable C interface to the solver, for embedding from C, Python (ctypes), C# and so on.
+   handles are opaque, every output goes into a buffer the caller owns, and nothing
+   throws across the boundary: failures come back as negative status codes.
+   build: g++ -std=gnu++17 -O2 -shared -fPIC -fvisibility=hidden -DSOLVE24_BUILD lib/solve24_c.cpp -o libsolve24.so -pthread
+   (make lib also links with lib/solve24_c.map); only the SOLVE24_API functions below are exported */
+
+#ifdef _WIN32
+#ifdef SOLVE24_BUILD
+#define SOLVE24_API __declspec(dllexport)
+#else
+#define SOLVE24_API __declspec(dllimport)
+#endif
+#else
+#define SOLVE24_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bumped only on incompatible changes */
+#define SOLVE24_ABI_VERSION 1
+
+#define SOLVE24_OK 0
+#define SOLVE24_NO_SOLUTION 1
+#define SOLVE24_ERROR_ARGUMENT -1
+#define SOLVE24_ERROR_BUFFER -2
+#define SOLVE24_ERROR_MEMORY -3
+#define SOLVE24_ERROR_INTERNAL -4
+
+typedef struct solve24_solver solve24_solver;
+
+SOLVE24_API int solve24_abi_version(void);
+
+/* a solver with its own transposition cache of cache_entries entries (0 for none); NULL on failure.
+   one handle must not be used from two threads at once */
+SOLVE24_API solve24_solver* solve24_create(size_t cache_entries);
+SOLVE24_API void solve24_destroy(solve24_solver* solver);
+
+/* SOLVE24_OK if numbers[0..count) can make target, SOLVE24_NO_SOLUTION if not */
+SOLVE24_API int solve24_is_solvable(solve24_solver* solver, const int* numbers, size_t count, double target);
+
+/* writes the first solution found as "a op b = c; ..." with a terminating NUL.
+   *needed (if not NULL) gets the buffer size required including the NUL, so a caller can
+   ask with a NULL buffer first. SOLVE24_ERROR_BUFFER if buffer_size is too small */
+SOLVE24_API int solve24_first_solution(solve24_solver* solver, const int* numbers, size_t count, double target,
+                                       char* buffer, size_t buffer_size, size_t* needed);
+
+/* number of solutions the exhaustive search generates, in *solutions */
+SOLVE24_API int solve24_count_solutions(solve24_solver* solver, const int* numbers, size_t count, double target,
+                                        long long* solutions);
+
+/* posts a request on a mapped shared-memory channel (lib/shm_channel.h, solve_24 channel-serve):
+   atomically bumps the doorbell of the header at channel and wakes the server if it sleeps.
+   for clients that cannot do atomic read-modify-writes themselves, like src/shm_client.py */
+SOLVE24_API void solve24_channel_ring(void* channel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,307 +2,1084 @@
 #include <string>
 #include <vector>
 #include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <csignal>
+#include <sstream>
+#include <fstream>
+#include <memory>
+#include "bloom_filter.h"
+#include "certificate.h"
+#include "countdown.h"
+#include "embedded_table.h"
+#include "hand_sampler.h"
+#include "huge_pages.h"
+#include "memory_budget.h"
+#include "metrics.h"
+#include "prefetch.h"
+#include "progress.h"
+#include "replay.h"
+#include "request_log.h"
+#include "shape_engine.h"
+#include "shm_channel.h"
+#include "solution.h"
+#include "solver.h"
+#include "spill.h"
+#include "target_index.h"
+#include "solvable_table.h"
+#include "transposition_cache.h"
+#include "unknown.h"
 using namespace std;
-class Solution{
-private:
-    vector<vector<string>> solutions;
-    vector<string> first_solution;
-    int max_generated;
-public:
-    vector<int> numbers;
-    double target;
-    Solution(vector<int> arg1){
-        numbers = arg1;
-        target = 24;
-        max_generated = 1024;
-    }
-    Solution(vector<int> arg1, double arg2){
-        numbers = arg1;
-        target = arg2;
-        max_generated = 1024;
-    }
-    Solution(vector<int> arg1, double arg2, int arg3){
-        numbers = arg1;
-        target = arg2;
-        max_generated = arg3;
-    }
-    vector<vector<string>> get_all_solutions(){
-        return solutions;
-    }
-    vector<string> get_first_solution(){
-        return first_solution;
-    }
-    int get_max_generated(){
-        return max_generated;
-    }
-    void set_max_generated(int arg1){
-        max_generated = arg1;
-    }
-public:
-    bool is_valid_input(){
-        vector<double> values(numbers.begin(), numbers.end());
-        return solution_exists(values, target);
-    } 
-    bool find_first_solution(){
-        vector<double> values(numbers.begin(), numbers.end());
-        vector<string> output;
-        return solve_first(values, output, target);
-    }
-    void find_all_solutions(){
-        solutions;
-        vector<double> values(numbers.begin(), numbers.end());
-        vector<string> output;
-        solve_all(values, output, target);
+
+static string flag_value(int argc, char** argv, const string& name, const string& fallback){
+    for(int i = 2; i + 1 < argc; i++)
+        if(name == argv[i]) return argv[i + 1];
+    return fallback;
+}
+
+static bool has_flag(int argc, char** argv, const string& name){
+    for(int i = 2; i < argc; i++)
+        if(name == argv[i]) return true;
+    return false;
+}
+
+//positional numbers from argv[first] up to the first --flag, each an int, "3/4" or "0.25"
+static bool read_numbers(int argc, char** argv, int first, vector<Rational>& numbers){
+    for(int i = first; i < argc && string(argv[i]).compare(0, 2, "--") != 0; i++){
+        Rational value;
+        if(!parse_rational(argv[i], value)) return false;
+        numbers.push_back(value);
+    }
+    return true;
+}
+
+static double seconds_since(chrono::steady_clock::time_point start){
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+//runs build(threads, board) on --threads workers, printing a progress line every --progress
+//seconds (0, the default, for none) from a reporter thread and a last one when it ends
+template<class Build>
+static void build_with_progress(int argc, char** argv, uint64_t hands, Build build){
+    int threads = max(1, atoi(flag_value(argc, argv, "--threads", "1").c_str()));
+    double every = atof(flag_value(argc, argv, "--progress", "0").c_str());
+    if(every <= 0){
+        build(threads, (ProgressBoard*)nullptr);
         return;
     }
-    void print_solutions(){
-        for(int i = 0; i < solutions.size(); i++){
-            cout << "Solution:" << endl;
-            print_output_cpp(solutions[i]);
-        }
+    ProgressBoard board(hands, threads);
+    board.start_reporter(every, [](const ProgressReport& report){ cout << "progress: " << report.to_string() << endl; });
+    build(threads, &board);
+    board.stop_reporter();
+    cout << "progress: " << board.report().to_string() << endl;
+}
+
+static uint64_t xorshift(uint64_t& state){
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+//random (hand, target) lookups against a SolvableTable or an embedded::SolvableView
+template<class Table>
+static void time_lookups(const Table& table, long long lookups, uint64_t& state){
+    uint64_t hands = table.get_hands();
+    long long span = table.get_max_target() - table.get_min_target() + 1;
+    long long solvable = 0;
+    TlbMissCounter tlb;
+    auto start = chrono::steady_clock::now();
+    tlb.start();
+    for(long long i = 0; i < lookups; i++){
+        uint64_t r = xorshift(state);
+        solvable += table.is_solvable(r % hands, table.get_min_target() + (long long)((r >> 32) % span));
     }
-private: 
-    void print_output_cpp(vector<string> output){
-        for(int i = 0; i < output.size(); i++) 
-            cout << output[i] << endl;
+    long long misses = tlb.stop();
+    double elapsed = seconds_since(start);
+    cout << "lookups: " << lookups << ", solvable " << solvable << ", " << elapsed * 1e9 / lookups << " ns/lookup";
+    if(misses >= 0) cout << ", dTLB misses " << misses << " (" << (double)misses / lookups << "/lookup)";
+    else cout << ", dTLB misses unavailable";
+    cout << endl;
+}
+
+//table-bench [--cards N] [--max-target T] [--lookups M] [--huge-pages off|thp|explicit] [--prefault]
+//            [--threads N] [--progress S] [--embedded]
+//builds (or --load's, or with --embedded takes the one compiled in) the solvability table,
+//then times random lookups and cached solves
+static int run_table_bench(int argc, char** argv){
+    HugePageSettings& settings = huge_page_settings();
+    if(!parse_huge_page_mode(flag_value(argc, argv, "--huge-pages", "thp"), settings.mode)){
+        cout << "unknown --huge-pages mode" << endl;
+        return 1;
     }
-private:
-    bool solution_exists(vector<double>& nums, double target){
-        if(nums.size() == 1){
-            return fabs(nums[0] - target) < 1e-8;
+    settings.prefault = has_flag(argc, argv, "--prefault");
+    int cards = atoi(flag_value(argc, argv, "--cards", "4").c_str());
+    long long max_target = atoll(flag_value(argc, argv, "--max-target", "1000").c_str());
+    long long lookups = atoll(flag_value(argc, argv, "--lookups", "20000000").c_str());
+    string load_path = flag_value(argc, argv, "--load", "");
+    string save_path = flag_value(argc, argv, "--save", "");
+
+    uint64_t state = 88172645463325252ULL;
+    auto start = chrono::steady_clock::now();
+    SolvableTable* table = nullptr;
+    if(has_flag(argc, argv, "--embedded")){
+        const embedded::SolvableView* view = embedded::find_solvable(cards, 13, 0, max_target);
+        if(view == nullptr){
+            cout << "no embedded table for " << cards << " cards up to " << max_target << " (see make embedded)" << endl;
+            return 1;
         }
-        double val;
-        for(int i = 0; i + 1 < nums.size(); ++i){
-            for(int j = i + 1; j < nums.size(); ++j){
-                vector<double> new_nums;
-                for(int k = 0; k < nums.size(); ++k)
-                    if(k != i && k != j) new_nums.push_back(nums[k]);
-                string val1 = to_string(nums[i]);
-                string val2 = to_string(nums[j]); 
-                //addition i, j
-                val = nums[i] + nums[j];
-                new_nums.push_back(val);
-                if(solution_exists(new_nums, target)){
-                    return true;
-                }
-                val = nums[i] * nums[j];
-                new_nums.back() = val;
-                if(solution_exists(new_nums, target)){
-                    return true;
-                }
-                //subtraction i, j
-                val = nums[i] - nums[j];
-                new_nums.back() = val;
-                if(solution_exists(new_nums, target)){
-                    return true;
-                }
-                //division i, j
-                val = nums[i] / nums[j];
-                new_nums.back() = val;
-                if(solution_exists(new_nums, target)){
-                    return true;
-                }
-                //subtraction j, i
-                val = nums[j] - nums[i];
-                new_nums.back() = val;
-                if(solution_exists(new_nums, target)){
-                    return true;
-                }
-                //division j, i
-                val = nums[j] / nums[i];
-                new_nums.back() = val;
-                if(solution_exists(new_nums, target)){
-                    return true;
-                }
-            }
+        cout << "table: " << view->get_hands() << " hands, " << view->get_bytes() / 1024 << " KiB embedded, ready in "
+             << seconds_since(start) << " s" << endl;
+        time_lookups(*view, lookups, state);
+    }
+    else{
+        table = load_path.empty() ? nullptr : SolvableTable::load(load_path);
+        if(table == nullptr){
+            table = new SolvableTable(cards, 13, 0, max_target);
+            build_with_progress(argc, argv, table->get_hands(), [&](int threads, ProgressBoard* board){ table->build(threads, board); });
         }
-        return false;
+        cout << "table: " << table->get_hands() << " hands, " << table->get_bytes() / 1024 << " KiB, pages="
+             << huge_page_mode_name(table->get_mode()) << ", ready in " << seconds_since(start) << " s" << endl;
+        if(!save_path.empty() && !table->save(save_path))
+            cout << "could not save table to " << save_path << endl;
+        time_lookups(*table, lookups, state);
     }
-    bool solve_first(vector<double>& nums, vector<string> prev_ops, double target){
-        if(nums.size() == 1){
-            if(fabs(nums[0] - target) < 1e-8){
-                print_output_cpp(prev_ops);
-                first_solution = prev_ops;
-                return true;
-            }
+    TlbMissCounter tlb;
+
+    TranspositionCache cache(atoll(flag_value(argc, argv, "--cache-entries", "4194304").c_str()));
+    int solves = atoi(flag_value(argc, argv, "--solves", "2000").c_str());
+    int found = 0;
+    start = chrono::steady_clock::now();
+    tlb.start();
+    for(int i = 0; i < solves; i++){
+        vector<int> hand(5);
+        for(int k = 0; k < 5; k++) hand[k] = 1 + (int)(xorshift(state) % 13);
+        Solution solver(hand, 24);
+        solver.set_cache(&cache);
+        found += solver.is_valid_input() ? 1 : 0;
+    }
+    long long misses = tlb.stop();
+    double elapsed = seconds_since(start);
+    cout << "cached solves: " << solves << " five-card hands, " << found << " solvable, "
+         << elapsed * 1e6 / solves << " us/solve, cache " << cache.get_bytes() / 1024 << " KiB pages="
+         << huge_page_mode_name(cache.get_mode()) << " hits " << cache.get_hits() << " misses " << cache.get_misses();
+    if(misses >= 0) cout << ", dTLB misses " << misses;
+    cout << endl;
+    delete table;
+    return 0;
+}
+
+//output steps come in groups of four: left, right, result, operator
+static string format_steps(const vector<string>& steps){
+    string line;
+    for(size_t i = 0; i + 3 < steps.size(); i += 4){
+        if(!line.empty()) line += "; ";
+        line += steps[i] + " " + steps[i + 3] + " " + steps[i + 1] + " = " + steps[i + 2];
+    }
+    return line;
+}
+
+//SIGUSR1 only writes a byte to this pipe (the one thing a handler may safely do); the
+//dump happens on a thread blocked reading it, not on the stdin loop, which a signal
+//does not wake
+static int dump_pipe[2] = {-1, -1};
+static void request_dump(int){
+#ifdef SIGUSR1
+    char wake = 1;
+    if(dump_pipe[1] >= 0 && write(dump_pipe[1], &wake, 1) < 0){}
+#endif
+}
+
+//per-process settings every request of the solve and replay modes runs with
+struct ServeOptions{
+    TranspositionCache* cache = nullptr;
+    size_t memory_cap = 0;
+    OverflowPolicy overflow_policy = OverflowPolicy::truncate;
+    string spill_directory = ".";
+    shared_ptr<SharedResultCache> shared_cache;
+    shared_ptr<SolvableFilter> filter;
+    shared_ptr<cert::CertificateStore> certificates;
+};
+
+//waits for the certificates a serving run submitted and says which were lost
+static void report_certificates(const ServeOptions& options){
+    if(!options.certificates) return;
+    options.certificates->wait_idle();
+    uint64_t failed = options.certificates->get_write_failures(), dropped = options.certificates->get_dropped();
+    if(failed > 0) cerr << failed << " certificates could not be written to " << options.certificates->get_directory() << endl;
+    if(dropped > 0) cerr << dropped << " unsolvable hands got no certificate: the builder queue was full" << endl;
+}
+
+static bool parse_serve_options(int argc, char** argv, ServeOptions& options){
+    options.memory_cap = strtoull(flag_value(argc, argv, "--memory-cap", "0").c_str(), nullptr, 10);
+    options.spill_directory = flag_value(argc, argv, "--spill-dir", ".");
+    size_t shared_entries = strtoull(flag_value(argc, argv, "--shared-cache", "0").c_str(), nullptr, 10);
+    if(shared_entries > 0) options.shared_cache.reset(new SharedResultCache(shared_entries));
+    string filter_path = flag_value(argc, argv, "--filter", "");
+    if(!filter_path.empty()){
+        options.filter.reset(SolvableFilter::load(filter_path));
+        if(!options.filter){
+            cout << "could not load filter " << filter_path << endl;
             return false;
         }
-        double val;
-        string input;
-        for(int i = 0; i + 1 < nums.size(); ++i){
-            for(int j = i + 1; j < nums.size(); ++j){
-                vector<string> output;
-                output = prev_ops;
-                vector<double> new_nums;
-                for(int k = 0; k < nums.size(); ++k)
-                    if(k != i && k != j) new_nums.push_back(nums[k]);
-                string val1 = to_string(nums[i]);
-                string val2 = to_string(nums[j]); 
-                output.push_back(val1);
-                output.push_back(val2);
-                //addition i, j
-                val = nums[i] + nums[j];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("+");
-                new_nums.push_back(val);
-                if(solve_first(new_nums, output, target)){
-                    return true;
-                }
-                output.pop_back();
-                output.pop_back();
-                val = nums[i] * nums[j];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("*");
-                new_nums.back() = val;
-                if(solve_first(new_nums, output, target)){
-                    return true;
-                }
-                //subtraction i, j
-                output.pop_back();
-                output.pop_back();
-                val = nums[i] - nums[j];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("-");
-                new_nums.back() = val;
-                if(solve_first(new_nums, output, target)){
-                    return true;
-                }
-                //division i, j
-                output.pop_back();
-                output.pop_back();
-                val = nums[i] / nums[j];
-                input = to_string(val);
-                output.push_back(to_string(val));
-                output.push_back("/");
-                new_nums.back() = val;
-                if(solve_first(new_nums, output, target)){
-                    return true;
-                }
-                output.pop_back();
-                output.pop_back();
-                output.pop_back();
-                output.pop_back();
-                output.push_back(val2);
-                output.push_back(val1);
-                //subtraction j, i
-                val = nums[j] - nums[i];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("-");
-                new_nums.back() = val;
-                if(solve_first(new_nums, output, target)){
-                    return true;
-                }
-                //division j, i
-                output.pop_back();
-                output.pop_back();
-                val = nums[j] / nums[i];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("/");
-                new_nums.back() = val;
-                if(solve_first(new_nums, output, target)){
-                    return true;
-                }
-                output.pop_back();
-                output.pop_back();
-                output.pop_back();
-                output.pop_back();
-            }
+    }
+    string certificate_dir = flag_value(argc, argv, "--certificates", "");
+    if(!certificate_dir.empty()){
+        options.certificates.reset(new cert::CertificateStore(certificate_dir));
+        if(!options.certificates->check_directory()){
+            cout << "cannot write certificates to " << certificate_dir << endl;
+            return false;
         }
+    }
+    string policy = flag_value(argc, argv, "--on-cap", "truncate");
+    if(policy == "truncate") options.overflow_policy = OverflowPolicy::truncate;
+    else if(policy == "count") options.overflow_policy = OverflowPolicy::count_only;
+    else if(policy == "spill") options.overflow_policy = OverflowPolicy::spill;
+    else{
+        cout << "unknown --on-cap policy " << policy << endl;
         return false;
     }
-    void solve_all(vector<double>& nums, vector<string> prev_ops, double target){
-        if(nums.size() == 1){
-            if(fabs(nums[0] - target) < 1e-8){
-                //print_output_cpp(prev_ops);
-                solutions.push_back(prev_ops);
-            }
+    return true;
+}
+
+static string all_line(const QueryStats& stats, size_t stored){
+    string line = to_string(stats.solution_count);
+    if(stats.count_only) line += " (count only: " + string(degrade_reason_name(stats.reason)) + ")";
+    else if(stats.truncated) line += " (truncated to " + to_string(stored) + ": " + degrade_reason_name(stats.reason) + ")";
+    return line + " [peak " + to_string(stats.high_water_bytes) + " bytes]";
+}
+
+//spilling needs the file-backed store only Solution has, so those requests still get a fresh one
+static string answer_with_solution(const SolveRequest& request, const ServeOptions& options){
+    Solution solver = Solution::from_rationals(request.numbers, request.target.to_double());
+    solver.set_verbose(false);
+    solver.set_cache(options.cache);
+    solver.set_filter(options.filter.get());
+    solver.set_memory_cap(options.memory_cap, options.overflow_policy);
+    solver.set_spill_directory(options.spill_directory);
+    if(request.mode == SolveMode::exists){
+        return solver.is_valid_input() ? "1" : "0";
+    }
+    if(request.mode == SolveMode::first){
+        return solver.find_first_solution() ? format_steps(solver.get_first_solution()) : "none";
+    }
+    if(request.mode == SolveMode::all){
+        solver.find_all_solutions();
+        vector<vector<string>> all = solver.get_all_solutions();
+        QueryStats stats = solver.get_query_stats();
+        string line = to_string(stats.solution_count);
+        if(stats.spill_failed){
+            return line + " (spill to " + options.spill_directory + " failed: " + degrade_reason_name(stats.reason)
+                 + ") [peak " + to_string(stats.high_water_bytes) + " bytes]";
+        }
+        if(stats.spilled){
+            return line + " (" + to_string(stats.spilled_solutions) + " unique spilled to " + stats.spill_path + ": "
+                 + degrade_reason_name(stats.reason) + ") [peak " + to_string(stats.high_water_bytes) + " bytes]";
         }
-        double val;
-        string input;
-        for(int i = 0; i + 1 < nums.size(); ++i){
-            for(int j = i + 1; j < nums.size(); ++j){
-                vector<string> output;
-                output = prev_ops;
-                vector<double> new_nums;
-                for(int k = 0; k < nums.size(); ++k)
-                    if(k != i && k != j) new_nums.push_back(nums[k]);
-                string val1 = to_string(nums[i]);
-                string val2 = to_string(nums[j]); 
-                output.push_back(val1);
-                output.push_back(val2);
-                //addition i, j
-                val = nums[i] + nums[j];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("+");
-                new_nums.push_back(val);
-                solve_all(new_nums, output, target);
-                output.pop_back();
-                output.pop_back();
-                val = nums[i] * nums[j];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("*");
-                new_nums.back() = val;
-                solve_all(new_nums, output, target);
-                //subtraction i, j
-                output.pop_back();
-                output.pop_back();
-                val = nums[i] - nums[j];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("-");
-                new_nums.back() = val;
-                solve_all(new_nums, output, target);
-                //division i, j
-                output.pop_back();
-                output.pop_back();
-                val = nums[i] / nums[j];
-                input = to_string(val);
-                output.push_back(to_string(val));
-                output.push_back("/");
-                new_nums.back() = val;
-                solve_all(new_nums, output, target);
-                output.pop_back();
-                output.pop_back();
-                output.pop_back();
-                output.pop_back();
-                output.push_back(val2);
-                output.push_back(val1);
-                //subtraction j, i
-                val = nums[j] - nums[i];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("-");
-                new_nums.back() = val;
-                solve_all(new_nums, output, target);
-                //division j, i
-                output.pop_back();
-                output.pop_back();
-                val = nums[j] / nums[i];
-                input = to_string(val);
-                output.push_back(input);
-                output.push_back("/");
-                new_nums.back() = val;
-                solve_all(new_nums, output, target);
-                output.pop_back();
-                output.pop_back();
-                output.pop_back();
-                output.pop_back();
+        line = all_line(stats, all.size());
+        for(size_t i = 0; i < all.size(); i++) line += " | " + format_steps(all[i]);
+        return line;
+    }
+    return to_string(solver.count_solutions());
+}
+
+//runs one request and returns the result line the solve mode prints. every serving
+//thread keeps one SolveContext, so steady-state requests reuse its buffers and cache
+static string answer_request(const SolveRequest& request, const ServeOptions& options){
+    if(options.overflow_policy == OverflowPolicy::spill && request.filter.is_default() && request.mode != SolveMode::best)
+        return answer_with_solution(request, options);
+    thread_local SolveContext context;
+    Solver solver;
+    solver.set_cache_entries(1 << 20);
+    solver.set_memory_cap(options.memory_cap, options.overflow_policy);
+    solver.set_shared_cache(options.shared_cache.get());
+    solver.set_filter(options.filter.get());
+    solver.set_certificates(options.certificates.get());
+    if(request.mode == SolveMode::exists){
+        return solver.is_solvable(context, request.numbers, request.target, request.filter) ? "1" : "0";
+    }
+    if(request.mode == SolveMode::first){
+        return solver.find_first(context, request.numbers, request.target, request.filter) ? format_steps(context.solution_strings(0)) : "none";
+    }
+    if(request.mode == SolveMode::all){
+        solver.find_all(context, request.numbers, request.target, request.filter);
+        string line = all_line(context.get_query_stats(), context.solutions_stored());
+        for(size_t i = 0; i < context.solutions_stored(); i++) line += " | " + format_steps(context.solution_strings(i));
+        return line;
+    }
+    if(request.mode == SolveMode::best){
+        size_t kept = solver.find_best(context, request.numbers, request.target, request.top, CostModel(), request.filter);
+        if(kept == 0) return "none";
+        string line;
+        for(size_t i = 0; i < kept; i++){
+            ostringstream cost;
+            cost << context.solution_cost(i);
+            line += (i ? " | " : "") + format_steps(context.solution_strings(i)) + " (cost " + cost.str() + ")";
+        }
+        return line;
+    }
+    return to_string(solver.count(context, request.numbers, request.target, request.filter));
+}
+
+//filter-bench [--cards N] [--max-target T] [--bits-per-key B] [--hands M] [--load F] [--save F] [--threads N] [--progress S]
+//builds the solvable-pair filter from a solvability table (or --load's it), measures its
+//false-positive rate against the table, and times screening random hands with and without it
+static int run_filter_bench(int argc, char** argv){
+    int cards = atoi(flag_value(argc, argv, "--cards", "4").c_str());
+    long long max_target = atoll(flag_value(argc, argv, "--max-target", "100").c_str());
+    double bits_per_key = atof(flag_value(argc, argv, "--bits-per-key", "10").c_str());
+    int hands = atoi(flag_value(argc, argv, "--hands", "200000").c_str());
+    string load_path = flag_value(argc, argv, "--load", "");
+    string save_path = flag_value(argc, argv, "--save", "");
+
+    auto start = chrono::steady_clock::now();
+    SolvableTable table(cards, 13, 0, max_target);
+    build_with_progress(argc, argv, table.get_hands(), [&](int threads, ProgressBoard* board){ table.build(threads, board); });
+    cout << "table: " << table.get_hands() << " hands, built in " << seconds_since(start) << " s" << endl;
+    start = chrono::steady_clock::now();
+    unique_ptr<SolvableFilter> filter(load_path.empty() ? new SolvableFilter(table, bits_per_key) : SolvableFilter::load(load_path));
+    if(!filter){
+        cout << "could not load filter " << load_path << endl;
+        return 1;
+    }
+    cout << "filter: " << filter->get_bytes() / 1024 << " KiB" << (filter->is_mapped() ? " (mapped)" : "")
+         << ", ready in " << seconds_since(start) << " s" << endl;
+    if(!save_path.empty() && !filter->save(save_path))
+        cout << "could not save filter to " << save_path << endl;
+
+    long long unsolvable = 0, rejected = 0;
+    for(uint64_t rank = 0; rank < table.get_hands(); rank++){
+        vector<int> hand = unrank_hand(rank, cards, 13);
+        for(long long t = 0; t <= max_target; t++){
+            bool solvable = table.is_solvable(rank, t);
+            bool rejects = filter->rejects(hand, (double)t);
+            if(solvable && rejects){
+                cout << "filter rejected a solvable pair" << endl;
+                return 1;
             }
+            unsolvable += !solvable;
+            rejected += rejects;
+        }
+    }
+    cout << "unsolvable pairs: " << unsolvable << ", rejected " << rejected << ", false positives "
+         << 100.0 * (unsolvable - rejected) / max(unsolvable, 1LL) << "%" << endl;
+
+    Solver solver;
+    SolveContext context;
+    vector<vector<int>> screened(hands, vector<int>(cards));
+    vector<double> targets(hands);
+    uint64_t state = 88172645463325252ULL;
+    for(int i = 0; i < hands; i++){
+        for(int k = 0; k < cards; k++) screened[i][k] = 1 + (int)(xorshift(state) % 13);
+        targets[i] = (double)(xorshift(state) % (max_target + 1));
+    }
+    for(int pass = 0; pass < 2; pass++){
+        solver.set_filter(pass ? filter.get() : nullptr);
+        int found = 0;
+        start = chrono::steady_clock::now();
+        for(int i = 0; i < hands; i++) found += solver.is_solvable(context, screened[i], targets[i]);
+        double elapsed = seconds_since(start);
+        cout << (pass ? "with filter: " : "search only: ") << found << " of " << hands << " solvable, "
+             << elapsed * 1e9 / hands << " ns/hand" << endl;
+    }
+    return 0;
+}
+
+//solve [--metrics-file F] [--metrics-socket P] [--capture F] [--filter F] [--certificates D] [--memory-cap BYTES [--on-cap truncate|count|spill] [--spill-dir D]]
+//answers "<exists|first|all|count|best> <target> <n1> <n2> ... [ops=+* must=/ whole nonneg] [top=K]" lines from
+//stdin, one result line each; the trailing tokens restrict which solutions count (see filter_spec.h),
+//and best returns the K simplest solutions under the default CostModel.
+//the metrics file is rewritten on SIGUSR1 (at once, even while stdin is idle) and at exit; the socket serves a fresh dump per connection.
+//--capture records every request in the replay capture format; --filter rejects unsolvable
+//hands with a filter file written by filter-bench --save before any search; --certificates
+//writes an unsolvability certificate to D for every hand answered "0" (see certify)
+static int run_solve(int argc, char** argv){
+    string metrics_file = flag_value(argc, argv, "--metrics-file", "");
+    string metrics_socket = flag_value(argc, argv, "--metrics-socket", "");
+    string capture_path = flag_value(argc, argv, "--capture", "");
+    if(!metrics_socket.empty() && !metrics().serve_socket(metrics_socket))
+        cout << "could not serve metrics on " << metrics_socket << endl;
+    CaptureWriter capture;
+    if(!capture_path.empty() && !capture.open(capture_path))
+        cout << "could not open capture file " << capture_path << endl;
+    ServeOptions options;
+    if(!parse_serve_options(argc, argv, options)) return 1;
+    TranspositionCache cache(1 << 20);
+    options.cache = &cache;
+    thread dumper;
+#ifdef SIGUSR1
+    if(!metrics_file.empty() && pipe(dump_pipe) == 0){
+        dumper = thread([&metrics_file](){
+            char wake;
+            while(read(dump_pipe[0], &wake, 1) == 1 && wake) metrics().dump_to_file(metrics_file);
+        });
+    }
+    signal(SIGUSR1, request_dump);
+#endif
+    string line;
+    while(getline(cin, line)){
+        istringstream in(line);
+        SolveRequest request;
+        if(!parse_request(in, request)){
+            cout << "error: expected <exists|first|all|count|best> <target> <numbers...> [ops=+* must=/ whole nonneg] [top=K]" << endl;
+            continue;
+        }
+        if(capture.is_open()) capture.write(request);
+        cout << answer_request(request, options) << endl;
+    }
+#ifdef SIGUSR1
+    if(dumper.joinable()){
+        char stop = 0;
+        if(write(dump_pipe[1], &stop, 1) == 1) dumper.join();
+        else dumper.detach();
+    }
+#endif
+    if(!metrics_file.empty()) metrics().dump_to_file(metrics_file);
+    report_certificates(options);
+    metrics().stop_socket();
+    return 0;
+}
+
+//capture-synth --out F [--count N] [--seed S] [--rate R]
+//writes a synthetic capture: mostly 4-card hands for 24, some 5 and 6 card hands and other
+//targets, repeated popular hands, and mostly exists/first queries, arriving as a poisson stream
+static int run_capture_synth(int argc, char** argv){
+    string out_path = flag_value(argc, argv, "--out", "");
+    if(out_path.empty()){
+        cout << "capture-synth needs --out" << endl;
+        return 1;
+    }
+    int count = atoi(flag_value(argc, argv, "--count", "10000").c_str());
+    uint64_t state = strtoull(flag_value(argc, argv, "--seed", "1").c_str(), nullptr, 10) * 2654435761ULL + 1;
+    double rate = atof(flag_value(argc, argv, "--rate", "2000").c_str());
+    ofstream out(out_path);
+    out << "# solve24-capture v1\n";
+    vector<SolveRequest> recent;
+    double offset = 0;
+    for(int i = 0; i < count; i++){
+        offset += -log(1.0 - (double)(xorshift(state) % 1000000) / 1000000.0) / rate * 1e9;
+        SolveRequest request;
+        int dice = (int)(xorshift(state) % 100);
+        if(dice < 15 && !recent.empty()){
+            request = recent[xorshift(state) % recent.size()];
+        }
+        else{
+            int cards = dice < 80 ? 4 : (dice < 95 ? 5 : 6);
+            for(int k = 0; k < cards; k++) request.numbers.push_back(1 + (int)(xorshift(state) % 13));
+            request.target = xorshift(state) % 10 < 8 ? 24 : (long long)(1 + xorshift(state) % 100);
+            int kind = (int)(xorshift(state) % 100);
+            request.mode = kind < 50 ? SolveMode::exists : (kind < 85 ? SolveMode::first : (kind < 95 ? SolveMode::count : SolveMode::all));
+            if(cards > 4 && (request.mode == SolveMode::all || request.mode == SolveMode::count)) request.mode = SolveMode::first;
+            recent.push_back(request);
+            if(recent.size() > 64) recent.erase(recent.begin());
+        }
+        request.offset_ns = (uint64_t)offset;
+        out << request.offset_ns << " " << format_request(request) << "\n";
+    }
+    return out ? 0 : 1;
+}
+
+//replay <capture> [--threads T] [--rate R | --open-loop [--speed X]] [--loops L] [--daemon] [--memory-cap BYTES ...]
+//replays a capture against the in-process library, or with --daemon against child
+//processes running this binary's solve mode, and reports throughput and latency percentiles
+static int run_replay(int argc, char** argv){
+    vector<SolveRequest> requests;
+    if(argc < 3 || !read_capture(argv[2], requests)){
+        cout << "could not read capture " << (argc < 3 ? "" : argv[2]) << endl;
+        return 1;
+    }
+    ReplayOptions options;
+    options.threads = atoi(flag_value(argc, argv, "--threads", "1").c_str());
+    options.loops = atoi(flag_value(argc, argv, "--loops", "1").c_str());
+    if(has_flag(argc, argv, "--rate")){
+        options.schedule = ReplaySchedule::fixed_rate;
+        options.rate = atof(flag_value(argc, argv, "--rate", "1000").c_str());
+    }
+    if(has_flag(argc, argv, "--open-loop")){
+        options.schedule = ReplaySchedule::open_loop;
+        options.speed = atof(flag_value(argc, argv, "--speed", "1").c_str());
+    }
+    ReplayReport report;
+    if(has_flag(argc, argv, "--daemon")){
+#ifndef _WIN32
+        //a child that failed to start shows up as a failed call, not as a SIGPIPE
+        signal(SIGPIPE, SIG_IGN);
+        string program = self_program(argv[0]);
+        vector<unique_ptr<DaemonClient>> clients;
+        for(int w = 0; w < options.threads; w++) clients.emplace_back(new DaemonClient(program));
+        report = replay(requests, options, [&](int worker) -> RequestHandler {
+            DaemonClient* client = clients[worker].get();
+            return [client](const SolveRequest& request){
+                string response;
+                return client->call(request, response);
+            };
+        });
+#else
+        cout << "--daemon is not supported on windows" << endl;
+        return 1;
+#endif
+    }
+    else{
+        ServeOptions serve;
+        if(!parse_serve_options(argc, argv, serve)) return 1;
+        report = replay(requests, options, [serve](int) -> RequestHandler {
+            //only spilled requests run on Solution and need a cache of their own
+            shared_ptr<TranspositionCache> cache;
+            if(serve.overflow_policy == OverflowPolicy::spill) cache.reset(new TranspositionCache(1 << 20));
+            return [cache, serve](const SolveRequest& request){
+                ServeOptions mine = serve;
+                mine.cache = cache.get();
+                answer_request(request, mine);
+                return true;
+            };
+        });
+        report_certificates(serve);
+    }
+    report.print(cout);
+    if(report.failed > 0){
+        cout << "replay aborted: a solve daemon gave no answer" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+//countdown <target> <numbers...>
+//countdown rules: any subset of the numbers, positive whole intermediates, and the
+//closest reachable value when the target itself cannot be made
+static int run_countdown(int argc, char** argv){
+    if(argc < 4){
+        cout << "countdown needs a target and at least one number" << endl;
+        return 1;
+    }
+    long long target = atoll(argv[2]);
+    if(target <= 0){
+        cout << "countdown targets must be positive" << endl;
+        return 1;
+    }
+    vector<int> numbers;
+    for(int i = 3; i < argc; i++) numbers.push_back(atoi(argv[i]));
+    if(numbers.size() > 10){
+        cout << "countdown takes at most 10 numbers" << endl;
+        return 1;
+    }
+    for(size_t i = 0; i < numbers.size(); i++){
+        if(numbers[i] <= 0){
+            cout << "countdown numbers must be positive" << endl;
+            return 1;
+        }
+    }
+    auto start = chrono::steady_clock::now();
+    countdown::Solver solver(numbers);
+    countdown::Result result = solver.solve(target);
+    double us = seconds_since(start) * 1e6;
+    cout << (result.exact ? "exact " : "closest ") << result.value << " = " << result.expression << endl;
+    cout << "(" << us << " us)" << endl;
+    return 0;
+}
+
+//certify <target> <numbers...> [--dir D]
+//answers a dispute: a solution when there is one, otherwise the unsolvability certificate
+//(from D when a serving process already wrote it there) checked by the independent verifier
+static int run_certify(int argc, char** argv){
+    if(argc < 4){
+        cout << "certify needs a target and at least one number" << endl;
+        return 1;
+    }
+    double target = atof(argv[2]);
+    vector<int> numbers;
+    for(int i = 3; i < argc && string(argv[i]).compare(0, 2, "--") != 0; i++) numbers.push_back(atoi(argv[i]));
+    if(numbers.empty() || numbers.size() > 8){
+        cout << "certify takes one to 8 numbers" << endl;
+        return 1;
+    }
+    cert::CertificateStore store(flag_value(argc, argv, "--dir", ""));
+    string bytes;
+    bool cached = store.find(numbers, target, bytes);
+    auto start = chrono::steady_clock::now();
+    if(!cached){
+        Solver solver;
+        SolveContext context;
+        if(solver.find_first(context, numbers, target)){
+            cout << "solvable: " << format_steps(context.solution_strings(0)) << endl;
+            return 0;
+        }
+        if(!store.certify(numbers, target) || !store.find(numbers, target, bytes)){
+            cout << "unsolvable, but the target has no exact form to certify" << endl;
+            return 1;
         }
+    }
+    double build_us = seconds_since(start) * 1e6;
+    start = chrono::steady_clock::now();
+    bool valid = cert::verify(bytes);
+    double verify_us = seconds_since(start) * 1e6;
+    cout << (valid ? "unsolvable: certificate " : "INVALID certificate ") << bytes.size() << " bytes"
+         << (cached ? " (cached)" : ", built in " + to_string(build_us) + " us") << ", verified in " << verify_us << " us" << endl;
+    return valid ? 0 : 1;
+}
+
+//cert-check <file>
+//runs only the independent verifier over a certificate file
+static int run_cert_check(int argc, char** argv){
+    if(argc < 3){
+        cout << "cert-check needs a certificate file" << endl;
+        return 1;
+    }
+    ifstream in(argv[2], ios::binary);
+    string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    vector<int> numbers;
+    Rational target;
+    if(!cert::verify(bytes, &numbers, &target)){
+        cout << "invalid" << endl;
+        return 1;
+    }
+    cout << "valid: ";
+    for(size_t i = 0; i < numbers.size(); i++) cout << numbers[i] << " ";
+    cout << "cannot make " << target.to_string() << endl;
+    return 0;
+}
+
+//expressions <target> <numbers...> [--list N]
+//walks every expression (tree shape x leaf order x operators) with the shape engine and
+//counts those equal to target, printing the first N of them
+static int run_expressions(int argc, char** argv){
+    if(argc < 4){
+        cout << "expressions needs a target and at least one number" << endl;
+        return 1;
+    }
+    Rational exact;
+    vector<Rational> given;
+    if(!parse_rational(argv[2], exact) || !read_numbers(argc, argv, 3, given)){
+        cout << "numbers must be ints, fractions like 3/4 or decimals like 0.25" << endl;
+        return 1;
+    }
+    double target = exact.to_double();
+    vector<double> numbers;
+    for(size_t i = 0; i < given.size(); i++) numbers.push_back(given[i].to_double());
+    if(numbers.empty() || numbers.size() > (size_t)shapes::MAX_LEAVES){
+        cout << "expressions takes one to " << shapes::MAX_LEAVES << " numbers" << endl;
+        return 1;
+    }
+    long long list = atoll(flag_value(argc, argv, "--list", "0").c_str());
+    shapes::ExpressionEngine engine;
+    long long visited = 0, hits = 0;
+    auto start = chrono::steady_clock::now();
+    engine.for_each_expression(numbers.data(), (int)numbers.size(), [&](double value){
+        visited++;
+        if(fabs(value - target) < 1e-8 && hits++ < list) cout << engine.describe() << " = " << target << endl;
+        return false;
+    });
+    double elapsed = seconds_since(start);
+    cout << hits << " of " << visited << " expressions (" << shapes::shapes_for((int)numbers.size()).size() << " shapes) make "
+         << target << ", " << elapsed * 1e3 << " ms, " << elapsed * 1e9 / max(visited, 1LL) << " ns and "
+         << (double)engine.get_evaluations() / max(visited, 1LL) << " node evaluations per expression" << endl;
+    return 0;
+}
+
+//unknown <target> <known numbers...> [--cards]
+//every exact x that makes the hand (known numbers plus x) reach target; --cards keeps only
+//the playable ones, whole numbers 1 to 13
+static int run_unknown(int argc, char** argv){
+    if(argc < 3){
+        cout << "unknown needs a target" << endl;
+        return 1;
+    }
+    Rational target;
+    vector<Rational> known;
+    if(!parse_rational(argv[2], target) || !read_numbers(argc, argv, 3, known)){
+        cout << "numbers must be ints, fractions like 3/4 or decimals like 0.25" << endl;
+        return 1;
+    }
+    if(known.size() > unknown::MAX_KNOWN){
+        cout << "unknown takes at most " << unknown::MAX_KNOWN << " known numbers" << endl;
+        return 1;
+    }
+    bool cards = has_flag(argc, argv, "--cards");
+    auto start = chrono::steady_clock::now();
+    unknown::Answer answer = unknown::solve(known, target);
+    double elapsed = seconds_since(start);
+    size_t shown = 0;
+    for(size_t i = 0; i < answer.values.size(); i++){
+        const Rational& x = answer.values[i];
+        if(cards && (!x.is_integer() || x.num < 1 || x.num > 13)) continue;
+        cout << (shown++ ? " " : "") << x.to_string();
+    }
+    if(shown) cout << endl;
+    if(answer.any){
+        cout << "any x works";
+        for(size_t i = 0; i < answer.except.size(); i++) cout << (i ? ", " : " except ") << answer.except[i].to_string();
+        cout << endl;
+    }
+    cout << shown << " values of x make " << target.to_string() << ", " << elapsed * 1e3 << " ms" << endl;
+    return 0;
+}
+
+static void request_checkpoint(int){
+    checkpoint::stop_requested = 1;
+}
+
+//enumerate <target> <numbers...> --checkpoint F [--every S] [--resume] [--list N] [--memory-cap BYTES --spill-dir D]
+//finds every solution, saving the search to F every S seconds and on SIGINT/SIGTERM (then
+//exiting); --resume continues from F exactly where it stopped. with --memory-cap the
+//solutions past the cap spill to a sorted file in D
+static int run_enumerate(int argc, char** argv){
+    string path = flag_value(argc, argv, "--checkpoint", "");
+    Rational target;
+    vector<Rational> numbers;
+    if(argc < 4 || path.empty()){
+        cout << "enumerate needs a target, numbers and --checkpoint F" << endl;
+        return 1;
+    }
+    if(!parse_rational(argv[2], target) || !read_numbers(argc, argv, 3, numbers)){
+        cout << "numbers must be ints, fractions like 3/4 or decimals like 0.25" << endl;
+        return 1;
+    }
+    Solution solution = Solution::from_rationals(numbers, target.to_double());
+    solution.set_max_generated(INT32_MAX);
+    size_t cap = strtoull(flag_value(argc, argv, "--memory-cap", "0").c_str(), nullptr, 10);
+    if(cap){
+        solution.set_memory_cap(cap, OverflowPolicy::spill);
+        solution.set_spill_directory(flag_value(argc, argv, "--spill-dir", "."));
+    }
+    solution.set_checkpoint(path, atof(flag_value(argc, argv, "--every", "60").c_str()));
+    signal(SIGINT, request_checkpoint);
+    signal(SIGTERM, request_checkpoint);
+    auto start = chrono::steady_clock::now();
+    if(!has_flag(argc, argv, "--resume")) solution.find_all_solutions();
+    else if(!solution.resume_all_solutions(path)){
+        cout << "could not resume from " << path << " (missing, damaged or for another hand)" << endl;
+        return 1;
+    }
+    double elapsed = seconds_since(start);
+    QueryStats stats = solution.get_query_stats();
+    if(solution.is_interrupted() && !solution.is_resumable()){
+        cout << "stopped after " << stats.solution_count << " solutions, " << stats.nodes << " nodes, " << elapsed
+             << " s; the checkpoint could not be written to " << path << ", so this run cannot be resumed" << endl;
+        return 1;
+    }
+    if(solution.is_interrupted()){
+        cout << "stopped after " << stats.solution_count << " solutions, " << stats.nodes << " nodes, " << elapsed
+             << " s; resume with --resume --checkpoint " << path << endl;
+        return 2;
+    }
+    if(stats.spill_failed){
+        cout << stats.solution_count << " solutions, but spilling them to " << flag_value(argc, argv, "--spill-dir", ".")
+             << " failed, so they are not listed" << endl;
+        return 1;
+    }
+    long long list = atoll(flag_value(argc, argv, "--list", "0").c_str());
+    vector<vector<string>> found = solution.get_all_solutions();
+    for(long long i = 0; i < list && i < (long long)found.size(); i++) cout << format_steps(found[i]) << endl;
+    //spilled solutions are read back from the merged file in place
+    MappedSolutions spilled;
+    if(stats.spilled && list > 0 && spilled.open(stats.spill_path)){
+        long long shown = 0;
+        spilled.for_each([&](const char* line, size_t length){
+            cout << format_steps(decode_solution(line, length)) << endl;
+            return ++shown >= list;
+        });
+    }
+    cout << stats.solution_count << " solutions, " << stats.nodes << " nodes, " << elapsed << " s";
+    if(stats.spilled) cout << ", " << stats.spilled_solutions << " distinct in " << stats.spill_path;
+    cout << endl;
+    return 0;
+}
+
+//the index over cards from 1..max_value and targets 1..max_target, from the embedded
+//difficulty table when the binary has one that covers it, else from a table built here
+static TargetIndex* build_index(int argc, char** argv, int cards, int max_value, long long max_target){
+    TargetIndex* index = new TargetIndex(cards, max_value, 1, max_target);
+    const embedded::DifficultyView* view = embedded::find_difficulty(cards, max_value, 1, max_target);
+    if(view){
+        index->build(*view);
+        return index;
+    }
+    difficulty::DifficultyTable table(cards, max_value, 1, max_target);
+    build_with_progress(argc, argv, table.get_hands(), [&](int threads, ProgressBoard* board){ table.build(threads, board); });
+    index->build(table);
+    return index;
+}
+
+//gen-table --out F [--cards N] [--max-value V] [--max-target T] [--threads N] [--progress S]
+//builds the solvability (targets 0..T) and difficulty (1..T) tables and writes them as a C++
+//source defining embedded::generated_solvable and generated_difficulty, for make embedded
+static int run_gen_table(int argc, char** argv){
+    string out_path = flag_value(argc, argv, "--out", "");
+    if(out_path.empty()){
+        cout << "gen-table needs --out" << endl;
+        return 1;
+    }
+    int cards = atoi(flag_value(argc, argv, "--cards", "4").c_str());
+    int max_value = atoi(flag_value(argc, argv, "--max-value", "13").c_str());
+    long long max_target = atoll(flag_value(argc, argv, "--max-target", "1000").c_str());
+    if(cards < 1 || cards > 8 || max_value < 1 || max_target < 1){
+        cout << "gen-table takes 1 to 8 cards, values and targets from 1" << endl;
+        return 1;
+    }
+    auto start = chrono::steady_clock::now();
+    SolvableTable solvable(cards, max_value, 0, max_target);
+    build_with_progress(argc, argv, solvable.get_hands(), [&](int threads, ProgressBoard* board){ solvable.build(threads, board); });
+    difficulty::DifficultyTable scores(cards, max_value, 1, max_target);
+    build_with_progress(argc, argv, scores.get_hands(), [&](int threads, ProgressBoard* board){ scores.build(threads, board); });
+    string command = "solve_24 gen-table --cards " + to_string(cards) + " --max-value " + to_string(max_value) + " --max-target " + to_string(max_target);
+    if(!embedded::write_source(out_path, command, solvable, scores)){
+        cout << "could not write " << out_path << endl;
+        return 1;
+    }
+    cout << "wrote " << out_path << ": " << solvable.get_hands() << " hands, targets up to " << max_target << ", "
+         << seconds_since(start) << " s" << endl;
+    return 0;
+}
+
+//index-query <target> [--also T2,T3] [--limit N] [--hardest] [--min-difficulty D] [--max-difficulty D]
+//            [--cards N] [--max-value V] [--max-target T] [--load F] [--save F] [--threads N] [--progress S]
+//lists hands that make target (and every --also target) from the inverted index, easiest first
+static int run_index_query(int argc, char** argv){
+    if(argc < 3){
+        cout << "index-query needs a target" << endl;
+        return 1;
+    }
+    long long target = atoll(argv[2]);
+    size_t limit = (size_t)atoll(flag_value(argc, argv, "--limit", "50").c_str());
+    int min_difficulty = atoi(flag_value(argc, argv, "--min-difficulty", "1").c_str());
+    int max_difficulty = atoi(flag_value(argc, argv, "--max-difficulty", "255").c_str());
+    string load_path = flag_value(argc, argv, "--load", "");
+    string save_path = flag_value(argc, argv, "--save", "");
+    vector<long long> targets = {target};
+    stringstream also(flag_value(argc, argv, "--also", ""));
+    string item;
+    while(getline(also, item, ','))
+        if(!item.empty()) targets.push_back(atoll(item.c_str()));
+
+    auto start = chrono::steady_clock::now();
+    TargetIndex* index = load_path.empty() ? nullptr : TargetIndex::load(load_path);
+    if(index == nullptr){
+        int cards = atoi(flag_value(argc, argv, "--cards", "4").c_str());
+        int max_value = atoi(flag_value(argc, argv, "--max-value", "13").c_str());
+        long long max_target = atoll(flag_value(argc, argv, "--max-target", "1000").c_str());
+        index = build_index(argc, argv, cards, max_value, max_target);
+    }
+    cout << "index: " << index->get_bytes() / 1024 << " KiB, ready in " << seconds_since(start) << " s" << endl;
+    if(!save_path.empty() && !index->save(save_path))
+        cout << "could not save index to " << save_path << endl;
+
+    vector<Posting> found;
+    start = chrono::steady_clock::now();
+    if(targets.size() == 1){
+        found = index->hands_for(target, limit, min_difficulty, max_difficulty, has_flag(argc, argv, "--hardest"));
+    }
+    else{
+        vector<uint32_t> ranks = index->intersect(targets);
+        for(size_t i = 0; i < ranks.size() && found.size() < limit; i++) found.push_back(Posting{ranks[i], 0});
+    }
+    double us = seconds_since(start) * 1e6;
+    for(size_t i = 0; i < found.size(); i++){
+        vector<int> hand = unrank_hand(found[i].rank, index->get_cards(), index->get_max_value());
+        for(size_t k = 0; k < hand.size(); k++) cout << (k ? " " : "") << hand[k];
+        if(found[i].difficulty) cout << "  difficulty " << (int)found[i].difficulty;
+        cout << endl;
+    }
+    cout << found.size() << " hands (" << us << " us)" << endl;
+    delete index;
+    return 0;
+}
+
+//sample <target> [--band LO:HI] [--count N] [--seed S] [--centered] [--quiet] [--load F] [--threads N] [--progress S]
+//draws solvable hands whose difficulty lies in the band; the same seed gives the same hands
+static int run_sample(int argc, char** argv){
+    if(argc < 3){
+        cout << "sample needs a target" << endl;
+        return 1;
+    }
+    long long target = atoll(argv[2]);
+    DifficultyBand band{1, 255};
+    string band_text = flag_value(argc, argv, "--band", "1:255");
+    if(sscanf(band_text.c_str(), "%d:%d", &band.min_difficulty, &band.max_difficulty) != 2 || band.min_difficulty > band.max_difficulty){
+        cout << "--band takes LO:HI" << endl;
+        return 1;
+    }
+    long long count = atoll(flag_value(argc, argv, "--count", "10").c_str());
+    SampleRng rng(strtoull(flag_value(argc, argv, "--seed", "1").c_str(), nullptr, 10));
+    string load_path = flag_value(argc, argv, "--load", "");
+    TargetIndex* index = load_path.empty() ? nullptr : TargetIndex::load(load_path);
+    if(index == nullptr){
+        index = build_index(argc, argv, 4, 13, max(100LL, target));
+    }
+    HandSampler sampler(*index, target, {band}, has_flag(argc, argv, "--centered") ? centered_weight : uniform_weight);
+    if(sampler.band_size(0) == 0){
+        cout << "no hands make " << target << " in difficulty band " << band_text << endl;
+        delete index;
+        return 1;
+    }
+    bool quiet = has_flag(argc, argv, "--quiet");
+    uint64_t checksum = 0;
+    Posting drawn{0, 0};
+    auto start = chrono::steady_clock::now();
+    for(long long i = 0; i < count; i++){
+        sampler.sample(0, rng, drawn);
+        checksum += drawn.rank;
+        if(quiet) continue;
+        vector<int> hand = unrank_hand(drawn.rank, index->get_cards(), index->get_max_value());
+        for(size_t k = 0; k < hand.size(); k++) cout << (k ? " " : "") << hand[k];
+        cout << "  difficulty " << (int)drawn.difficulty << endl;
+    }
+    double elapsed = seconds_since(start);
+    cout << count << " draws from " << sampler.band_size(0) << " hands, " << (elapsed > 0 ? count / elapsed / 1e6 : 0)
+         << " M draws/s (checksum " << checksum << ")" << endl;
+    delete index;
+    return 0;
+}
+
+//prefetch [--cards N] [--target T] [--depth D] [--seed S]
+//feeder for the game: keeps depth solvable hands prepared in the background and answers
+//every stdin line with the next one as "<numbers...> | <target> | <difficulty> | <first solution>",
+//or "none" once 10000 random draws in a row have found no hand that makes the target
+static int run_prefetch(int argc, char** argv){
+    int cards = atoi(flag_value(argc, argv, "--cards", "4").c_str());
+    long long target = atoll(flag_value(argc, argv, "--target", "24").c_str());
+    size_t depth = (size_t)atoi(flag_value(argc, argv, "--depth", "8").c_str());
+    if(cards < 1 || cards > 6){
+        cout << "prefetch takes 1 to 6 cards" << endl;
+        return 1;
+    }
+    SampleRng rng(strtoull(flag_value(argc, argv, "--seed", "1").c_str(), nullptr, 10));
+    TranspositionCache cache(1 << 20);
+    PrefetchQueue queue([&](PreparedHand& hand){
+        hand.numbers.clear();
+        for(int k = 0; k < cards; k++) hand.numbers.push_back(1 + (int)(rng.next() % 13));
+        hand.target = target;
+        Solution solver(hand.numbers, (double)target);
+        solver.set_verbose(false);
+        solver.set_cache(&cache);
+        if(!solver.find_first_solution()) return false;
+        hand.solution = format_steps(solver.get_first_solution());
+        uint8_t score = 0;
+        difficulty::score_targets(hand.numbers, target, target, &score);
+        hand.difficulty = score;
+        return true;
+    }, depth);
+    string line;
+    while(getline(cin, line)){
+        PreparedHand hand;
+        if(!queue.pop(hand)){
+            cout << "none" << endl;
+            continue;
+        }
+        for(size_t k = 0; k < hand.numbers.size(); k++) cout << (k ? " " : "") << hand.numbers[k];
+        cout << " | " << hand.target << " | " << hand.difficulty << " | " << hand.solution << endl;
+    }
+    return 0;
+}
+
+//steps in the short form the shared-memory channel returns, e.g. "3 * 8 = 24; ..."
+static string compact_steps(const vector<string>& steps){
+    ostringstream out;
+    for(size_t i = 0; i + 3 < steps.size(); i += 4){
+        if(i) out << "; ";
+        out << atof(steps[i].c_str()) << " " << steps[i + 3] << " " << atof(steps[i + 1].c_str()) << " = " << atof(steps[i + 2].c_str());
+    }
+    return out.str();
+}
+
+static void answer_slot(shm::Slot& slot, TranspositionCache& cache){
+    uint32_t count = slot.count < shm::MAX_NUMBERS ? slot.count : shm::MAX_NUMBERS;
+    Solution solver(vector<int>(slot.numbers, slot.numbers + count), slot.target);
+    solver.set_verbose(false);
+    solver.set_cache(&cache);
+    slot.text_length = 0;
+    if(slot.kind == shm::kind_exists){
+        slot.result = solver.is_valid_input() ? 1 : 0;
         return;
     }
+    slot.result = solver.find_first_solution() ? 1 : 0;
+    if(!slot.result) return;
+    string text = compact_steps(solver.get_first_solution());
+    slot.text_length = (uint32_t)min<size_t>(text.size(), shm::TEXT_BYTES);
+    memcpy(slot.text, text.data(), slot.text_length);
+}
 
-};
+static atomic<bool> channel_stop(false);
+static void request_channel_stop(int){
+    channel_stop.store(true);
+}
+
+//channel-serve <path> [--slots N]
+//answers exists/hint requests over the shared-memory channel at path until SIGINT or SIGTERM
+static int run_channel_serve(int argc, char** argv){
+    if(argc < 3){
+        cout << "channel-serve needs a path, e.g. /dev/shm/solve24" << endl;
+        return 1;
+    }
+    shm::Channel channel;
+    if(!channel.create(argv[2], (uint32_t)atoi(flag_value(argc, argv, "--slots", "16").c_str()))){
+        cout << "could not create channel " << argv[2] << endl;
+        return 1;
+    }
+    signal(SIGINT, request_channel_stop);
+    signal(SIGTERM, request_channel_stop);
+    TranspositionCache cache(1 << 20);
+    cout << "serving " << channel.slot_count() << " slots on " << argv[2] << endl;
+    channel.serve([&](shm::Slot& slot){ answer_slot(slot, cache); }, channel_stop);
+    return 0;
+}
 
+//channel-bench [--requests N] [--path P]
+//round trips through a channel served by a thread of this process, with latency percentiles
+static int run_channel_bench(int argc, char** argv){
+    string path = flag_value(argc, argv, "--path", "/dev/shm/solve24-bench");
+    long long requests = atoll(flag_value(argc, argv, "--requests", "100000").c_str());
+    shm::Channel server_side, client_side;
+    if(!server_side.create(path, 4) || !client_side.open(path)){
+        cout << "could not set up channel " << path << endl;
+        return 1;
+    }
+    TranspositionCache cache(1 << 20);
+    thread server([&](){ server_side.serve([&](shm::Slot& slot){ answer_slot(slot, cache); }, channel_stop); });
+    shm::Client client(client_side, 0);
+    uint64_t state = 88172645463325252ULL;
+    vector<uint64_t> latency(HISTOGRAM_BUCKETS, 0);
+    long long solvable = 0;
+    for(long long i = 0; i < requests; i++){
+        shm::Slot& slot = client.request();
+        slot.kind = i % 4 == 0 ? shm::kind_hint : shm::kind_exists;
+        slot.count = 4;
+        slot.target = 24;
+        for(int k = 0; k < 4; k++) slot.numbers[k] = 1 + (int)(xorshift(state) % 13);
+        auto start = chrono::steady_clock::now();
+        client.call();
+        latency[histogram_bucket((uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count())]++;
+        solvable += slot.result;
+        client.release();
+    }
+    channel_stop.store(true);
+    server.join();
+    cout << requests << " round trips, " << solvable << " solvable: p50 " << histogram_quantile(latency, 0.5) / 1000.0
+         << " us, p99 " << histogram_quantile(latency, 0.99) / 1000.0 << " us, max " << histogram_quantile(latency, 1.0) / 1000.0 << " us" << endl;
+    return 0;
+}
 
-int main(){
+int main(int argc, char** argv){
+    if(argc > 1){
+        string mode = argv[1];
+        if(mode == "table-bench") return run_table_bench(argc, argv);
+        if(mode == "solve") return run_solve(argc, argv);
+        if(mode == "capture-synth") return run_capture_synth(argc, argv);
+        if(mode == "replay") return run_replay(argc, argv);
+        if(mode == "countdown") return run_countdown(argc, argv);
+        if(mode == "index-query") return run_index_query(argc, argv);
+        if(mode == "sample") return run_sample(argc, argv);
+        if(mode == "prefetch") return run_prefetch(argc, argv);
+        if(mode == "channel-serve") return run_channel_serve(argc, argv);
+        if(mode == "channel-bench") return run_channel_bench(argc, argv);
+        if(mode == "filter-bench") return run_filter_bench(argc, argv);
+        if(mode == "certify") return run_certify(argc, argv);
+        if(mode == "expressions") return run_expressions(argc, argv);
+        if(mode == "cert-check") return run_cert_check(argc, argv);
+        if(mode == "unknown") return run_unknown(argc, argv);
+        if(mode == "enumerate") return run_enumerate(argc, argv);
+        if(mode == "gen-table") return run_gen_table(argc, argv);
+        cout << "unknown mode " << mode << endl;
+        return 1;
+    }
     //get all solutions by running find_first_solution on all combinations
     vector<int> test = {1, 3, 4, 6};
     double practice_target = 36;
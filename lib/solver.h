@@ -0,0 +1,668 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bloom_filter.h"
+#include "certificate.h"
+#include "concurrent_cache.h"
+#include "filter_spec.h"
+#include "memory_budget.h"
+#include "metrics.h"
+#include "rational.h"
+#include "transposition_cache.h"
+
+//the same search as Solution, split for serving: a Solver is configuration only
+//(operators, limits, cache size) and is never written by a query, so one instance
+//can be shared by any number of threads. everything a query writes lives in a
+//SolveContext, one per thread, whose buffers are kept between queries: after the
+//first few queries have grown them, serving allocates nothing.
+//search order matches Solution, so the first solution found is the same one
+struct SolveStep{
+    double left;
+    double right;
+    double result;
+    char op;
+    //the earlier step that made left / right, or -1 for a number of the hand. only find_best
+    //records them (first and all leave -1); they are what tells equal values apart
+    int8_t left_step = -1;
+    int8_t right_step = -1;
+};
+
+//what find_best minimises, summed over the steps of a solution plus height times the
+//height of its expression tree. every weight must be >= 0: the search prunes a branch as
+//soon as its partial cost reaches the k-th best, which is only sound if cost never shrinks
+struct CostModel{
+    double add = 1;
+    double sub = 1;
+    double mul = 1;
+    double div = 1.5;
+    //x * 1, x / 1, x + 0, x - 0: steps that leave a value unchanged, instead of their operator's cost
+    double trivial = 0.25;
+    //added per fractional intermediate value
+    double fraction = 2;
+    //added per negative intermediate value
+    double negative = 1;
+    double height = 0.5;
+
+    double step(const SolveStep& s) const {
+        bool unchanged = (s.op == '*' && (s.left == 1 || s.right == 1)) || (s.op == '/' && s.right == 1)
+                      || (s.op == '+' && (s.left == 0 || s.right == 0)) || (s.op == '-' && s.right == 0);
+        double cost = unchanged ? trivial : s.op == '+' ? add : s.op == '-' ? sub : s.op == '*' ? mul : div;
+        if(std::fabs(s.result - std::round(s.result)) > 1e-8) cost += fraction;
+        if(s.result < -1e-8) cost += negative;
+        return cost;
+    }
+    double cheapest_step() const { return std::min(std::min(std::min(add, sub), std::min(mul, div)), trivial); }
+};
+
+class Solver;
+
+class SolveContext{
+    friend class Solver;
+private:
+    std::vector<double> scratch;
+    //tree height and lowest leaf index of each scratch value, for find_best
+    std::vector<uint8_t> heights;
+    std::vector<uint8_t> labels;
+    //the step that made each scratch value, -1 for the hand's numbers, for find_best
+    std::vector<int8_t> sources;
+    std::vector<SolveStep> path;
+    //stored solutions back to back, steps_per_solution steps each
+    std::vector<SolveStep> stored;
+    size_t steps_per_solution;
+    //cost of each stored solution after find_best, and its tree_key while searching
+    std::vector<double> costs;
+    std::vector<std::string> keys;
+    long long solution_count;
+    uint64_t nodes;
+    bool truncated;
+    bool count_only;
+    MemoryBudget budget;
+    QueryStats stats;
+    std::unique_ptr<TranspositionCache> cache;
+    size_t cache_entries;
+    //a Rational hand whose numbers are all ints, copied for the int entry points
+    std::vector<int> whole;
+    //scratch values and target of a hand searched exactly (the Rational overloads of Solver)
+    std::vector<Rational> exact;
+    Rational exact_target;
+
+    void prepare(size_t n){
+        if(scratch.size() < n * (n + 1) / 2) scratch.resize(n * (n + 1) / 2);
+        if(path.size() < n) path.resize(n);
+        stored.clear();
+        costs.clear();
+        keys.clear();
+        steps_per_solution = n > 0 ? n - 1 : 0;
+        solution_count = 0;
+        nodes = 0;
+        truncated = false;
+        count_only = false;
+        budget.reset();
+        stats = QueryStats();
+        budget.force(scratch.capacity() * sizeof(double) + path.capacity() * sizeof(SolveStep));
+    }
+public:
+    SolveContext() : steps_per_solution(0), solution_count(0), nodes(0), truncated(false), count_only(false), cache_entries(0) {}
+    SolveContext(const SolveContext&) = delete;
+    SolveContext& operator=(const SolveContext&) = delete;
+
+    size_t solutions_stored() const { return steps_per_solution ? stored.size() / steps_per_solution : 0; }
+    size_t get_steps_per_solution() const { return steps_per_solution; }
+    const SolveStep* solution(size_t i) const { return stored.data() + i * steps_per_solution; }
+    double solution_cost(size_t i) const { return i < costs.size() ? costs[i] : 0; }
+    //the four-strings-per-step form Solution::get_first_solution returns
+    std::vector<std::string> solution_strings(size_t i) const {
+        std::vector<std::string> steps;
+        const SolveStep* s = solution(i);
+        for(size_t k = 0; k < steps_per_solution; k++){
+            steps.push_back(std::to_string(s[k].left));
+            steps.push_back(std::to_string(s[k].right));
+            steps.push_back(std::to_string(s[k].result));
+            steps.push_back(std::string(1, s[k].op));
+        }
+        return steps;
+    }
+    QueryStats get_query_stats() const { return stats; }
+    long long get_solution_count() const { return solution_count; }
+    uint64_t get_nodes_searched() const { return nodes; }
+    bool is_truncated() const { return truncated; }
+    TranspositionCache* get_cache() const { return cache.get(); }
+};
+
+class Solver{
+public:
+    static const unsigned OP_ADD = 1;
+    static const unsigned OP_SUB = 2;
+    static const unsigned OP_MUL = 4;
+    static const unsigned OP_DIV = 8;
+    static const unsigned OP_ALL = 15;
+private:
+    unsigned ops;
+    int max_generated;
+    size_t memory_cap;
+    OverflowPolicy overflow_policy;
+    size_t cache_entries;
+    SharedResultCache* shared;
+    const SolvableFilter* filter;
+    cert::CertificateStore* certificates;
+
+    struct Query{
+        SolveContext& context;
+        double target;
+        bool stop_at_first;
+        unsigned ops;
+        const FilterSpec& spec;
+    };
+
+    //the operations Solution tries, in its order: a+b, a*b, a-b, a/b, b-a, b/a. visit gets
+    //(left, right, value, op, swapped), swapped when b is the left operand
+    template<class Visit>
+    static bool for_each_result(unsigned ops, double a, double b, Visit&& visit){
+        if((ops & OP_ADD) && visit(a, b, a + b, '+', false)) return true;
+        if((ops & OP_MUL) && visit(a, b, a * b, '*', false)) return true;
+        if((ops & OP_SUB) && visit(a, b, a - b, '-', false)) return true;
+        if((ops & OP_DIV) && visit(a, b, a / b, '/', false)) return true;
+        if((ops & OP_SUB) && visit(b, a, b - a, '-', true)) return true;
+        if((ops & OP_DIV) && visit(b, a, b / a, '/', true)) return true;
+        return false;
+    }
+    //the same over exact values; a step that divides by zero or overflows is skipped
+    template<class Visit>
+    static bool for_each_result(unsigned ops, const Rational& a, const Rational& b, Visit&& visit){
+        Rational v;
+        if((ops & OP_ADD) && add(a, b, v) && visit(a, b, v, '+', false)) return true;
+        if((ops & OP_MUL) && mul(a, b, v) && visit(a, b, v, '*', false)) return true;
+        if((ops & OP_SUB) && sub(a, b, v) && visit(a, b, v, '-', false)) return true;
+        if((ops & OP_DIV) && div(a, b, v) && visit(a, b, v, '/', false)) return true;
+        if((ops & OP_SUB) && sub(b, a, v) && visit(b, a, v, '-', true)) return true;
+        if((ops & OP_DIV) && div(b, a, v) && visit(b, a, v, '/', true)) return true;
+        return false;
+    }
+    //whether a step made with op may lead to a solution under spec: steps_left more
+    //steps follow it, and each can supply at most one missing required operator
+    static bool admits(const FilterSpec& spec, double value, unsigned used, size_t steps_left){
+        if(spec.whole && std::fabs(value - std::round(value)) > 1e-8) return false;
+        if(spec.non_negative && value < -1e-8) return false;
+        return (size_t)__builtin_popcount(spec.required & ~used) <= steps_left;
+    }
+    static bool admits(const FilterSpec& spec, const Rational& value, unsigned used, size_t steps_left){
+        if(spec.whole && !value.is_integer()) return false;
+        if(spec.non_negative && value.num < 0) return false;
+        return (size_t)__builtin_popcount(spec.required & ~used) <= steps_left;
+    }
+    static bool at_target(const SolveContext&, double value, double target){ return std::fabs(value - target) < 1e-8; }
+    static bool at_target(const SolveContext& c, const Rational& value, double){ return value == c.exact_target; }
+    //the transposition cache key of a sub-hand, when the context has a cache and m is worth it
+    bool cache_key(const SolveContext& c, const double* nums, size_t m, double target, uint64_t& key) const {
+        if(!c.cache || m < 3) return false;
+        key = TranspositionCache::fingerprint(nums, m, target) ^ ((uint64_t)ops << 56);
+        return true;
+    }
+    //the cache is keyed by doubles, so exact values are never cached
+    bool cache_key(const SolveContext&, const Rational*, size_t, double, uint64_t&) const { return false; }
+
+    //nums holds m values; the next level is written right after them in the scratch buffer.
+    //Number is double, or Rational for a hand searched exactly
+    template<class Number>
+    bool exists(SolveContext& c, Number* nums, size_t m, double target) const {
+        c.nodes++;
+        if(m == 1) return at_target(c, nums[0], target);
+        uint64_t key = 0;
+        bool found;
+        bool cached = cache_key(c, nums, m, target, key);
+        if(cached && c.cache->lookup(key, found)) return found;
+        found = false;
+        Number* next = nums + m;
+        for(size_t i = 0; i + 1 < m && !found; i++){
+            for(size_t j = i + 1; j < m && !found; j++){
+                size_t n = 0;
+                for(size_t k = 0; k < m; k++)
+                    if(k != i && k != j) next[n++] = nums[k];
+                found = for_each_result(ops, nums[i], nums[j], [&](const Number&, const Number&, const Number& value, char, bool){
+                    next[n] = value;
+                    return exists(c, next, m - 1, target);
+                });
+            }
+        }
+        if(cached) c.cache->store(key, found);
+        return found;
+    }
+
+    //leaf handling for first and all; returns true to stop the search
+    bool record(const Query& q) const {
+        SolveContext& c = q.context;
+        c.solution_count++;
+        if(c.count_only) return false;
+        if(!q.stop_at_first && (int)c.solutions_stored() >= max_generated){
+            overflow(c, DegradeReason::max_generated);
+            return false;
+        }
+        size_t bytes = c.steps_per_solution * sizeof(SolveStep);
+        if(q.stop_at_first) c.budget.force(bytes);
+        else if(!c.budget.charge(bytes)){
+            overflow(c, DegradeReason::memory_cap);
+            return false;
+        }
+        c.stats.solution_bytes += bytes;
+        c.stored.insert(c.stored.end(), c.path.begin(), c.path.begin() + c.steps_per_solution);
+        return q.stop_at_first;
+    }
+    void overflow(SolveContext& c, DegradeReason reason) const {
+        c.truncated = true;
+        if(c.stats.reason == DegradeReason::none) c.stats.reason = reason;
+        if(reason == DegradeReason::memory_cap && overflow_policy == OverflowPolicy::count_only){
+            c.budget.release(c.stats.solution_bytes);
+            c.stats.solution_bytes = 0;
+            c.stored.clear();
+            c.count_only = true;
+        }
+    }
+    //Constrained adds the FilterSpec checks; the unconstrained instance is the plain search.
+    //used is the mask of operators on the path so far
+    template<bool Constrained, class Number>
+    bool search(const Query& q, Number* nums, size_t m, size_t depth, unsigned used) const {
+        SolveContext& c = q.context;
+        c.nodes++;
+        if(m == 1) return at_target(c, nums[0], q.target) && record(q);
+        Number* next = nums + m;
+        for(size_t i = 0; i + 1 < m; i++){
+            for(size_t j = i + 1; j < m; j++){
+                size_t n = 0;
+                for(size_t k = 0; k < m; k++)
+                    if(k != i && k != j) next[n++] = nums[k];
+                bool stop = for_each_result(q.ops, nums[i], nums[j], [&](const Number& left, const Number& right, const Number& value, char op, bool){
+                    unsigned now = Constrained ? used | op_bit(op) : 0;
+                    if(Constrained && !admits(q.spec, value, now, m - 2)) return false;
+                    c.path[depth] = SolveStep{value_of(left), value_of(right), value_of(value), op};
+                    next[n] = value;
+                    return search<Constrained>(q, next, m - 1, depth + 1, now);
+                });
+                if(stop) return true;
+            }
+        }
+        return false;
+    }
+
+    //branch and bound for find_best: solutions are kept in c.stored with their costs in
+    //c.costs, at most limit of them; once full, a branch whose partial cost (plus the
+    //cheapest possible remaining steps) reaches the worst kept cost is cut. a sub-hand
+    //that cannot reach the target at all is cut through the context's exists cache.
+    //each tree is walked in one step order only: the value made last always sits at
+    //nums[m - 1], and a step that does not use it must have a higher label (lowest leaf
+    //index) than that value, which keeps exactly the smallest-label-first order
+    struct BestQuery{
+        SolveContext& context;
+        double target;
+        size_t limit;
+        const CostModel& cost;
+        unsigned ops;
+        const FilterSpec& spec;
+    };
+    size_t worst_kept(const SolveContext& c) const {
+        size_t worst = 0;
+        for(size_t i = 1; i < c.costs.size(); i++) if(c.costs[i] > c.costs[worst]) worst = i;
+        return worst;
+    }
+    //the expression tree under step at, with the operands of + and * in a fixed order: two
+    //solutions are the same one exactly when their root keys match. equal values from
+    //different subtrees (2 against 8 / 4) stay apart because steps record where operands came from
+    static std::string tree_key(const SolveStep* steps, int at){
+        const SolveStep& s = steps[at];
+        std::string left, right;
+        if(s.left_step < 0){
+            char number[32];
+            std::snprintf(number, sizeof(number), "%.17g", s.left);
+            left = number;
+        }
+        else left = tree_key(steps, s.left_step);
+        if(s.right_step < 0){
+            char number[32];
+            std::snprintf(number, sizeof(number), "%.17g", s.right);
+            right = number;
+        }
+        else right = tree_key(steps, s.right_step);
+        if((s.op == '+' || s.op == '*') && right < left) std::swap(left, right);
+        return "(" + left + s.op + right + ")";
+    }
+    void keep_best(const BestQuery& q, double total) const {
+        SolveContext& c = q.context;
+        c.solution_count++;
+        size_t steps = c.steps_per_solution;
+        std::string key = steps ? tree_key(c.path.data(), (int)steps - 1) : std::string();
+        for(size_t i = 0; i < c.costs.size(); i++){
+            if(c.keys[i] != key) continue;
+            if(total < c.costs[i]){
+                std::copy(c.path.begin(), c.path.begin() + steps, c.stored.begin() + i * steps);
+                c.costs[i] = total;
+            }
+            return;
+        }
+        if(c.costs.size() < q.limit){
+            c.stored.insert(c.stored.end(), c.path.begin(), c.path.begin() + steps);
+            c.costs.push_back(total);
+            c.keys.push_back(key);
+            return;
+        }
+        size_t worst = worst_kept(c);
+        if(total >= c.costs[worst]) return;
+        std::copy(c.path.begin(), c.path.begin() + steps, c.stored.begin() + worst * steps);
+        c.costs[worst] = total;
+        c.keys[worst] = key;
+    }
+    template<class Number>
+    void best(const BestQuery& q, Number* nums, uint8_t* heights, uint8_t* labels, int8_t* sources, size_t m, size_t depth, double cost, uint8_t height, unsigned used) const {
+        SolveContext& c = q.context;
+        c.nodes++;
+        if(m == 1){
+            if(at_target(c, nums[0], q.target)) keep_best(q, cost + q.cost.height * height);
+            return;
+        }
+        double bound = c.costs.size() < q.limit ? INFINITY : c.costs[worst_kept(c)];
+        //the finished tree is at least as tall as the shortest tree over these subtrees (kraft)
+        uint64_t kraft = 0;
+        for(size_t k = 0; k < m; k++) kraft += 1ULL << heights[k];
+        uint8_t lowest = (uint8_t)(64 - __builtin_clzll(kraft - 1));
+        if(cost + q.cost.height * std::max(height, lowest) + q.cost.cheapest_step() * (m - 1) >= bound) return;
+        uint64_t key;
+        if(cache_key(c, nums, m, q.target, key) && !exists(c, nums, m, q.target)) return;
+        Number* next = nums + m;
+        uint8_t* next_heights = heights + m;
+        uint8_t* next_labels = labels + m;
+        int8_t* next_sources = sources + m;
+        bool constrained = !q.spec.is_default();
+        for(size_t i = 0; i + 1 < m; i++){
+            for(size_t j = i + 1; j < m; j++){
+                uint8_t label = std::min(labels[i], labels[j]);
+                if(depth > 0 && j != m - 1 && label < labels[m - 1]) continue;
+                size_t n = 0;
+                for(size_t k = 0; k < m; k++){
+                    if(k != i && k != j){
+                        next_heights[n] = heights[k];
+                        next_labels[n] = labels[k];
+                        next_sources[n] = sources[k];
+                        next[n++] = nums[k];
+                    }
+                }
+                next_labels[n] = label;
+                next_sources[n] = (int8_t)depth;
+                uint8_t h = (uint8_t)(std::max(heights[i], heights[j]) + 1);
+                for_each_result(q.ops, nums[i], nums[j], [&](const Number& left, const Number& right, const Number& value, char op, bool swapped){
+                    unsigned now = used | op_bit(op);
+                    if(constrained && !admits(q.spec, value, now, m - 2)) return false;
+                    SolveStep step{value_of(left), value_of(right), value_of(value), op, swapped ? sources[j] : sources[i], swapped ? sources[i] : sources[j]};
+                    c.path[depth] = step;
+                    next[n] = value;
+                    next_heights[n] = h;
+                    best(q, next, next_heights, next_labels, next_sources, m - 1, depth + 1, cost + q.cost.step(step), std::max(height, h), now);
+                    return false;
+                });
+            }
+        }
+    }
+
+    //runs the plain search for the default spec and the constrained one otherwise
+    template<class Number>
+    bool run(const Query& q, Number* nums, size_t size) const {
+        if(q.spec.is_default()) return search<false>(q, nums, size, 0, 0);
+        if(q.spec.required & ~q.ops) return false;
+        return search<true>(q, nums, size, 0, 0);
+    }
+    void certify(const int* numbers, size_t size, double target) const {
+        if(numbers && certificates && ops == OP_ALL) certificates->submit(std::vector<int>(numbers, numbers + size), target);
+    }
+    //the filter, shared cache and certificates are keyed by int hands; a hand searched
+    //exactly is searched without them
+    static const int* int_hand(const int* numbers){ return numbers; }
+    static const int* int_hand(const Rational*){ return nullptr; }
+    //an int hand is searched in doubles, a Rational one in exact values
+    static double* scratch_for(SolveContext& c, const int*){ return c.scratch.data(); }
+    static Rational* scratch_for(SolveContext& c, const Rational*){ return c.exact.data(); }
+    static void load(SolveContext& c, const int* numbers, size_t count){
+        for(size_t i = 0; i < count; i++) c.scratch[i] = numbers[i];
+    }
+    static void load(SolveContext& c, const Rational* numbers, size_t count){
+        if(c.exact.size() < c.scratch.size()) c.exact.resize(c.scratch.size());
+        std::copy(numbers, numbers + count, c.exact.begin());
+    }
+    //sets the target the exact search compares against; returns it as the double the rest of the query uses
+    static double aim(SolveContext& c, const Rational& target){
+        c.exact_target = target;
+        return target.to_double();
+    }
+    static double value_of(double v){ return v; }
+    static double value_of(const Rational& v){ return v.to_double(); }
+    //fills c.whole when every number is an int and so is target (and doubles hold it
+    //exactly), so the hand takes the int path unchanged
+    static bool integral(SolveContext& c, const Rational* numbers, size_t size, const Rational& target){
+        c.whole.clear();
+        if(!target.is_integer() || target.num > (1LL << 53) || target.num < -(1LL << 53)) return false;
+        for(size_t i = 0; i < size; i++){
+            if(!numbers[i].is_integer() || numbers[i].num > INT32_MAX || numbers[i].num < INT32_MIN) return false;
+            c.whole.push_back((int)numbers[i].num);
+        }
+        return true;
+    }
+    template<class Number>
+    std::chrono::steady_clock::time_point begin(SolveContext& c, const Number* numbers, size_t count) const {
+        if(cache_entries > 0 && c.cache_entries != cache_entries){
+            c.cache.reset(new TranspositionCache(cache_entries));
+            c.cache_entries = cache_entries;
+        }
+        c.prepare(count);
+        c.budget.set_cap(memory_cap);
+        load(c, numbers, count);
+        return std::chrono::steady_clock::now();
+    }
+    void end(SolveContext& c, SolveMode mode, std::chrono::steady_clock::time_point start) const {
+        MetricsRegistry& registry = metrics();
+        registry.record_request(mode, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        registry.add(Counter::nodes, c.nodes);
+        registry.add(Counter::solutions, (uint64_t)c.solution_count);
+        if(c.truncated) registry.add(Counter::truncations, 1);
+        c.stats.high_water_bytes = c.budget.get_high_water();
+        c.stats.cap_bytes = c.budget.get_cap();
+        c.stats.cache_bytes = c.cache ? c.cache->get_bytes() : 0;
+        c.stats.truncated = c.truncated;
+        c.stats.solution_count = c.solution_count;
+        c.stats.nodes = c.nodes;
+    }
+public:
+    Solver() : ops(OP_ALL), max_generated(1024), memory_cap(0), overflow_policy(OverflowPolicy::truncate), cache_entries(0), shared(nullptr), filter(nullptr), certificates(nullptr) {}
+
+    //configure before sharing; a Solver in use by several threads must not be changed
+    void set_ops(unsigned arg1){ ops = arg1 & OP_ALL; }
+    void set_max_generated(int arg1){ max_generated = arg1; }
+    //spill needs Solution; here it degrades like truncate
+    void set_memory_cap(size_t bytes, OverflowPolicy policy){
+        memory_cap = bytes;
+        overflow_policy = policy;
+    }
+    //entries of the transposition cache every context keeps for itself (0 = none)
+    void set_cache_entries(size_t arg1){ cache_entries = arg1; }
+    //whole-hand verdicts and counts shared between threads; not owned
+    void set_shared_cache(SharedResultCache* arg1){ shared = arg1; }
+    //definite "unsolvable" for hands the filter covers before any search or cache probe; not owned.
+    //fewer operators never make more targets, so this holds for any ops mask
+    void set_filter(const SolvableFilter* arg1){ filter = arg1; }
+    //every "unsolvable" is_solvable answers with all four operators is submitted here, so the
+    //store's background builder makes its certificate without holding up the query; not owned
+    void set_certificates(cert::CertificateStore* arg1){ certificates = arg1; }
+    unsigned get_ops() const { return ops; }
+    int get_max_generated() const { return max_generated; }
+
+private:
+    //the queries, for Number int or Rational. they are reached through the overloads below, so
+    //a Rational hand always has its exact target set and an all-int one takes the int instance.
+    //a spec other than the default is answered by the constrained first-solution search,
+    //without the shared cache or certificates
+    template<class Number>
+    bool is_solvable(SolveContext& c, const Number* numbers, size_t size, double target, const FilterSpec& spec = FilterSpec()) const {
+        if(size == 0) return false;
+        const int* hand = int_hand(numbers);
+        std::chrono::steady_clock::time_point start = begin(c, numbers, size);
+        if(!spec.is_default()){
+            bool found = !(hand && filter && filter->rejects(hand, size, target)) && run(Query{c, target, true, ops & spec.ops, spec}, scratch_for(c, numbers), size);
+            end(c, SolveMode::exists, start);
+            return found;
+        }
+        if(hand && filter && filter->rejects(hand, size, target)){
+            c.solution_count = 0;
+            certify(hand, size, target);
+            end(c, SolveMode::exists, start);
+            return false;
+        }
+        bool keyed = hand && shared;
+        uint64_t key = keyed ? SharedResultCache::hand_key(hand, size, target, ops | (uint64_t)SolveMode::exists << 8) : 0;
+        uint64_t answer;
+        if(keyed && shared->lookup(key, answer)){
+            metrics().add(Counter::cache_hits, 1);
+            c.solution_count = (long long)answer;
+            if(answer == 0) certify(hand, size, target);
+            end(c, SolveMode::exists, start);
+            return answer != 0;
+        }
+        uint64_t hits = c.cache ? c.cache->get_hits() : 0, misses = c.cache ? c.cache->get_misses() : 0;
+        bool found = exists(c, scratch_for(c, numbers), size, target);
+        if(keyed) shared->store(key, found ? 1 : 0);
+        c.solution_count = found ? 1 : 0;
+        if(!found) certify(hand, size, target);
+        if(c.cache){
+            metrics().add(Counter::cache_hits, c.cache->get_hits() - hits);
+            metrics().add(Counter::cache_misses, c.cache->get_misses() - misses);
+        }
+        end(c, SolveMode::exists, start);
+        return found;
+    }
+    //the first solution is left in the context as solution(0)
+    template<class Number>
+    bool find_first(SolveContext& c, const Number* numbers, size_t size, double target, const FilterSpec& spec = FilterSpec()) const {
+        if(size == 0) return false;
+        const int* hand = int_hand(numbers);
+        std::chrono::steady_clock::time_point start = begin(c, numbers, size);
+        bool found = !(hand && filter && filter->rejects(hand, size, target)) && run(Query{c, target, true, ops & spec.ops, spec}, scratch_for(c, numbers), size);
+        end(c, SolveMode::first, start);
+        return found;
+    }
+    //stores up to max_generated solutions (and what the memory cap allows); returns how many there are
+    template<class Number>
+    long long find_all(SolveContext& c, const Number* numbers, size_t size, double target, const FilterSpec& spec = FilterSpec()) const {
+        if(size == 0) return 0;
+        std::chrono::steady_clock::time_point start = begin(c, numbers, size);
+        run(Query{c, target, false, ops & spec.ops, spec}, scratch_for(c, numbers), size);
+        c.stats.count_only = c.count_only;
+        end(c, SolveMode::all, start);
+        return c.solution_count;
+    }
+    //the limit cheapest distinct solutions under cost, cheapest first as solution(0..), with
+    //solution_cost(i); returns how many were kept. the cut uses the context's exists cache when
+    //the solver has cache_entries, and otherwise only the cost bound
+    template<class Number>
+    size_t find_best(SolveContext& c, const Number* numbers, size_t size, double target, size_t limit,
+                     const CostModel& cost = CostModel(), const FilterSpec& spec = FilterSpec()) const {
+        if(size == 0 || limit == 0) return 0;
+        const int* hand = int_hand(numbers);
+        std::chrono::steady_clock::time_point start = begin(c, numbers, size);
+        if(c.heights.size() < c.scratch.size()){
+            c.heights.resize(c.scratch.size());
+            c.labels.resize(c.scratch.size());
+            c.sources.resize(c.scratch.size());
+        }
+        for(size_t i = 0; i < size; i++){
+            c.heights[i] = 0;
+            c.labels[i] = (uint8_t)i;
+            c.sources[i] = -1;
+        }
+        bool possible = !(hand && filter && filter->rejects(hand, size, target)) && !(spec.required & ~(ops & spec.ops));
+        if(possible) best(BestQuery{c, target, limit, cost, ops & spec.ops, spec}, scratch_for(c, numbers), c.heights.data(), c.labels.data(), c.sources.data(), size, 0, 0, 0, 0);
+        //cheapest first; insertion sort, there are only limit of them
+        size_t steps = c.steps_per_solution;
+        for(size_t i = 1; i < c.costs.size(); i++){
+            for(size_t j = i; j > 0 && c.costs[j] < c.costs[j - 1]; j--){
+                std::swap(c.costs[j], c.costs[j - 1]);
+                std::swap(c.keys[j], c.keys[j - 1]);
+                std::swap_ranges(c.stored.begin() + j * steps, c.stored.begin() + (j + 1) * steps, c.stored.begin() + (j - 1) * steps);
+            }
+        }
+        c.solution_count = (long long)c.costs.size();
+        end(c, SolveMode::best, start);
+        return c.costs.size();
+    }
+    template<class Number>
+    long long count(SolveContext& c, const Number* numbers, size_t size, double target, const FilterSpec& spec = FilterSpec()) const {
+        if(size == 0) return 0;
+        const int* hand = int_hand(numbers);
+        std::chrono::steady_clock::time_point start = begin(c, numbers, size);
+        c.count_only = true;
+        bool keyed = hand && shared;
+        uint64_t key = keyed ? SharedResultCache::hand_key(hand, size, target, ops | (uint64_t)SolveMode::count << 8 | (uint64_t)spec.tag() << 16) : 0;
+        uint64_t answer;
+        if(hand && filter && filter->rejects(hand, size, target)) c.solution_count = 0;
+        else if(keyed && shared->lookup(key, answer)){
+            metrics().add(Counter::cache_hits, 1);
+            c.solution_count = (long long)answer;
+        }
+        else{
+            run(Query{c, target, false, ops & spec.ops, spec}, scratch_for(c, numbers), size);
+            if(keyed) shared->store(key, (uint64_t)c.solution_count);
+        }
+        c.stats.count_only = true;
+        end(c, SolveMode::count, start);
+        return c.solution_count;
+    }
+
+public:
+    bool is_solvable(SolveContext& c, const int* numbers, size_t size, double target, const FilterSpec& spec = FilterSpec()) const {
+        return is_solvable<int>(c, numbers, size, target, spec);
+    }
+    bool find_first(SolveContext& c, const int* numbers, size_t size, double target, const FilterSpec& spec = FilterSpec()) const {
+        return find_first<int>(c, numbers, size, target, spec);
+    }
+    long long find_all(SolveContext& c, const int* numbers, size_t size, double target, const FilterSpec& spec = FilterSpec()) const {
+        return find_all<int>(c, numbers, size, target, spec);
+    }
+    size_t find_best(SolveContext& c, const int* numbers, size_t size, double target, size_t limit,
+                     const CostModel& cost = CostModel(), const FilterSpec& spec = FilterSpec()) const {
+        return find_best<int>(c, numbers, size, target, limit, cost, spec);
+    }
+    long long count(SolveContext& c, const int* numbers, size_t size, double target, const FilterSpec& spec = FilterSpec()) const {
+        return count<int>(c, numbers, size, target, spec);
+    }
+    //exact fractions and decimals (see parse_rational). a hand of ints with an int target
+    //takes the int path and loses nothing; anything else is searched over Rational values
+    //and must make target exactly, skipping steps that divide by zero or overflow
+    bool is_solvable(SolveContext& c, const Rational* numbers, size_t size, const Rational& target, const FilterSpec& spec = FilterSpec()) const {
+        return integral(c, numbers, size, target) ? is_solvable(c, c.whole.data(), size, target.to_double(), spec) : is_solvable<Rational>(c, numbers, size, aim(c, target), spec);
+    }
+    bool find_first(SolveContext& c, const Rational* numbers, size_t size, const Rational& target, const FilterSpec& spec = FilterSpec()) const {
+        return integral(c, numbers, size, target) ? find_first(c, c.whole.data(), size, target.to_double(), spec) : find_first<Rational>(c, numbers, size, aim(c, target), spec);
+    }
+    long long find_all(SolveContext& c, const Rational* numbers, size_t size, const Rational& target, const FilterSpec& spec = FilterSpec()) const {
+        return integral(c, numbers, size, target) ? find_all(c, c.whole.data(), size, target.to_double(), spec) : find_all<Rational>(c, numbers, size, aim(c, target), spec);
+    }
+    size_t find_best(SolveContext& c, const Rational* numbers, size_t size, const Rational& target, size_t limit,
+                     const CostModel& cost = CostModel(), const FilterSpec& spec = FilterSpec()) const {
+        return integral(c, numbers, size, target) ? find_best(c, c.whole.data(), size, target.to_double(), limit, cost, spec) : find_best<Rational>(c, numbers, size, aim(c, target), limit, cost, spec);
+    }
+    long long count(SolveContext& c, const Rational* numbers, size_t size, const Rational& target, const FilterSpec& spec = FilterSpec()) const {
+        return integral(c, numbers, size, target) ? count(c, c.whole.data(), size, target.to_double(), spec) : count<Rational>(c, numbers, size, aim(c, target), spec);
+    }
+
+    bool is_solvable(SolveContext& c, const std::vector<int>& numbers, double target, const FilterSpec& spec = FilterSpec()) const { return is_solvable(c, numbers.data(), numbers.size(), target, spec); }
+    bool find_first(SolveContext& c, const std::vector<int>& numbers, double target, const FilterSpec& spec = FilterSpec()) const { return find_first(c, numbers.data(), numbers.size(), target, spec); }
+    long long find_all(SolveContext& c, const std::vector<int>& numbers, double target, const FilterSpec& spec = FilterSpec()) const { return find_all(c, numbers.data(), numbers.size(), target, spec); }
+    long long count(SolveContext& c, const std::vector<int>& numbers, double target, const FilterSpec& spec = FilterSpec()) const { return count(c, numbers.data(), numbers.size(), target, spec); }
+    size_t find_best(SolveContext& c, const std::vector<int>& numbers, double target, size_t limit,
+                     const CostModel& cost = CostModel(), const FilterSpec& spec = FilterSpec()) const { return find_best(c, numbers.data(), numbers.size(), target, limit, cost, spec); }
+    bool is_solvable(SolveContext& c, const std::vector<Rational>& numbers, const Rational& target, const FilterSpec& spec = FilterSpec()) const { return is_solvable(c, numbers.data(), numbers.size(), target, spec); }
+    bool find_first(SolveContext& c, const std::vector<Rational>& numbers, const Rational& target, const FilterSpec& spec = FilterSpec()) const { return find_first(c, numbers.data(), numbers.size(), target, spec); }
+    long long find_all(SolveContext& c, const std::vector<Rational>& numbers, const Rational& target, const FilterSpec& spec = FilterSpec()) const { return find_all(c, numbers.data(), numbers.size(), target, spec); }
+    long long count(SolveContext& c, const std::vector<Rational>& numbers, const Rational& target, const FilterSpec& spec = FilterSpec()) const { return count(c, numbers.data(), numbers.size(), target, spec); }
+    size_t find_best(SolveContext& c, const std::vector<Rational>& numbers, const Rational& target, size_t limit,
+                     const CostModel& cost = CostModel(), const FilterSpec& spec = FilterSpec()) const { return find_best(c, numbers.data(), numbers.size(), target, limit, cost, spec); }
+};
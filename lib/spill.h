@@ -0,0 +1,273 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <queue>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//one solution per line: its steps joined by single spaces
+inline std::string encode_solution(const std::vector<std::string>& steps){
+    std::string line;
+    for(size_t i = 0; i < steps.size(); i++){
+        if(i) line.push_back(' ');
+        line += steps[i];
+    }
+    return line;
+}
+
+inline std::vector<std::string> decode_solution(const char* line, size_t length){
+    std::vector<std::string> steps;
+    size_t start = 0;
+    for(size_t i = 0; i <= length; i++){
+        if(i == length || line[i] == ' '){
+            if(i > start) steps.push_back(std::string(line + start, i - start));
+            start = i + 1;
+        }
+    }
+    return steps;
+}
+
+//what a checkpoint needs to reopen a SpillWriter. run files are never changed before
+//finish, so the ones listed stay valid for as long as the checkpoint does
+struct SpillState{
+    std::string prefix;
+    std::vector<std::string> runs;
+    int next_run = 0;
+    uint64_t written = 0;
+};
+
+//external-memory store for result sets larger than RAM. encoded solutions are
+//buffered up to buffer_limit bytes, sorted and deduplicated into run files, and
+//finish() merges the runs (at most MERGE_FAN_IN at a time) into one sorted,
+//duplicate-free file with one solution per line. memory use is the buffer plus
+//one line per open run, however many solutions are written
+class SpillWriter{
+private:
+    std::string directory;
+    std::string prefix;
+    size_t buffer_limit;
+    size_t buffered_bytes;
+    std::vector<std::string> buffer;
+    std::vector<std::string> runs;
+    int next_run;
+    uint64_t written;
+
+    static const size_t MERGE_FAN_IN = 64;
+
+    std::string run_path(){
+        return directory + "/" + prefix + "-run" + std::to_string(next_run++) + ".txt";
+    }
+    bool flush_buffer(){
+        if(buffer.empty()) return true;
+        std::sort(buffer.begin(), buffer.end());
+        buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+        std::string path = run_path();
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if(!f) return false;
+        bool ok = true;
+        for(size_t i = 0; i < buffer.size() && ok; i++)
+            ok = std::fwrite(buffer[i].data(), 1, buffer[i].size(), f) == buffer[i].size() && std::fputc('\n', f) != EOF;
+        ok = std::fclose(f) == 0 && ok;
+        runs.push_back(path);
+        std::vector<std::string>().swap(buffer);
+        buffered_bytes = 0;
+        return ok;
+    }
+    //merges sorted run files into out, dropping duplicates; returns the lines written or -1
+    static long long merge(const std::vector<std::string>& inputs, const std::string& out){
+        typedef std::pair<std::string, size_t> Head;
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        std::vector<FILE*> files;
+        bool ok = true;
+        for(size_t i = 0; i < inputs.size(); i++){
+            FILE* f = std::fopen(inputs[i].c_str(), "rb");
+            files.push_back(f);
+            std::string line;
+            if(!f) ok = false;
+            else if(read_line(f, line)) heads.push(Head(line, i));
+        }
+        FILE* o = std::fopen(out.c_str(), "wb");
+        long long count = 0;
+        std::string last;
+        bool have_last = false;
+        while(ok && o && !heads.empty()){
+            Head head = heads.top();
+            heads.pop();
+            if(!have_last || head.first != last){
+                ok = std::fwrite(head.first.data(), 1, head.first.size(), o) == head.first.size() && std::fputc('\n', o) != EOF;
+                last = head.first;
+                have_last = true;
+                count++;
+            }
+            std::string line;
+            if(read_line(files[head.second], line)) heads.push(Head(line, head.second));
+        }
+        for(size_t i = 0; i < files.size(); i++) if(files[i]) std::fclose(files[i]);
+        if(!o || std::fclose(o) != 0) ok = false;
+        return ok ? count : -1;
+    }
+    static bool read_line(FILE* f, std::string& line){
+        line.clear();
+        int c;
+        while((c = std::fgetc(f)) != EOF && c != '\n') line.push_back((char)c);
+        return c != EOF || !line.empty();
+    }
+public:
+    SpillWriter(const std::string& arg1, const std::string& arg2, size_t arg3){
+        directory = arg1;
+        prefix = arg2;
+        buffer_limit = arg3;
+        buffered_bytes = 0;
+        next_run = 0;
+        written = 0;
+    }
+    //reopens the writer a checkpoint saved; runs it writes from here reuse the same names
+    SpillWriter(const std::string& arg1, const SpillState& arg2, size_t arg3){
+        directory = arg1;
+        prefix = arg2.prefix;
+        buffer_limit = arg3;
+        buffered_bytes = 0;
+        runs = arg2.runs;
+        next_run = arg2.next_run;
+        written = arg2.written;
+    }
+    ~SpillWriter(){
+        for(size_t i = 0; i < runs.size(); i++) std::remove(runs[i].c_str());
+    }
+    SpillWriter(const SpillWriter&) = delete;
+    SpillWriter& operator=(const SpillWriter&) = delete;
+
+    size_t get_buffer_limit() const { return buffer_limit; }
+    uint64_t get_written() const { return written; }
+
+    //flushes the buffer to a run so that state lists everything written so far
+    bool checkpoint(SpillState& state){
+        if(!flush_buffer()) return false;
+        state.prefix = prefix;
+        state.runs = runs;
+        state.next_run = next_run;
+        state.written = written;
+        return true;
+    }
+    //forgets the runs without deleting them, for a checkpoint that outlives this writer
+    void detach(){ runs.clear(); }
+
+    bool add(const std::string& encoded){
+        buffered_bytes += encoded.size() + sizeof(std::string);
+        buffer.push_back(encoded);
+        written++;
+        return buffered_bytes < buffer_limit || flush_buffer();
+    }
+
+    //writes the final sorted unique set to path and returns its line count, or -1
+    long long finish(const std::string& path){
+        if(!flush_buffer()) return -1;
+        while(runs.size() > MERGE_FAN_IN){
+            std::vector<std::string> merged;
+            for(size_t i = 0; i < runs.size(); i += MERGE_FAN_IN){
+                std::vector<std::string> group(runs.begin() + i, runs.begin() + std::min(runs.size(), i + MERGE_FAN_IN));
+                std::string out = run_path();
+                if(merge(group, out) < 0) return -1;
+                for(size_t k = 0; k < group.size(); k++) std::remove(group[k].c_str());
+                merged.push_back(out);
+            }
+            runs.swap(merged);
+        }
+        long long count = merge(runs, path);
+        for(size_t i = 0; i < runs.size(); i++) std::remove(runs[i].c_str());
+        runs.clear();
+        return count;
+    }
+};
+
+//read-only memory map of a spilled result file; lines are walked in place
+class MappedSolutions{
+private:
+    const char* base;
+    size_t length;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+public:
+    MappedSolutions() : base(nullptr), length(0) {
+#ifdef _WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#endif
+    }
+    ~MappedSolutions(){ close(); }
+    MappedSolutions(const MappedSolutions&) = delete;
+    MappedSolutions& operator=(const MappedSolutions&) = delete;
+
+    bool open(const std::string& path){
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if(file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if(!GetFileSizeEx(file, &size)){ close(); return false; }
+        length = (size_t)size.QuadPart;
+        if(length == 0) return true;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(!mapping){ close(); return false; }
+        base = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(!base){ close(); return false; }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) return false;
+        struct stat st;
+        if(fstat(fd, &st) != 0){ ::close(fd); return false; }
+        length = (size_t)st.st_size;
+        if(length > 0){
+            void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if(p == MAP_FAILED){ ::close(fd); length = 0; return false; }
+            madvise(p, length, MADV_SEQUENTIAL);
+            base = (const char*)p;
+        }
+        ::close(fd);
+#endif
+        return true;
+    }
+    void close(){
+#ifdef _WIN32
+        if(base) UnmapViewOfFile(base);
+        if(mapping) CloseHandle(mapping);
+        if(file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if(base) munmap((void*)base, length);
+#endif
+        base = nullptr;
+        length = 0;
+    }
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+
+    //calls visit(const char* line, size_t length) for every line, without copying, until
+    //visit returns true
+    template<class Visit>
+    void for_each(Visit&& visit) const {
+        size_t start = 0;
+        for(size_t i = 0; i < length; i++){
+            if(base[i] == '\n'){
+                if(visit(base + start, i - start)) return;
+                start = i + 1;
+            }
+        }
+        if(start < length) visit(base + start, length - start);
+    }
+};
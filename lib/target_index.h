@@ -0,0 +1,293 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "difficulty.h"
+
+//inverted index from target to the hands that make it. each target's posting
+//list holds hand ranks in increasing order, cut into blocks of BLOCK_SIZE: a block
+//keeps its first rank in the clear and the rest as (gap - 1) bit-packed at the
+//block's own width. the difficulty of every posting sits in a parallel byte array.
+//the clear first ranks double as a skip list, so intersection decodes only the
+//blocks that can still match
+struct Posting{
+    uint32_t rank;
+    uint8_t difficulty;
+};
+
+class TargetIndex{
+private:
+    struct Block{
+        uint32_t first;
+        uint32_t word;
+        uint32_t bits;
+    };
+    int cards;
+    int max_value;
+    long long min_target;
+    long long max_target;
+    //target t owns postings [posting_start[t], posting_start[t + 1]) and the matching blocks
+    std::vector<uint32_t> posting_start;
+    std::vector<uint32_t> block_start;
+    std::vector<Block> blocks;
+    std::vector<uint64_t> packed;
+    std::vector<uint8_t> difficulties;
+
+    static uint32_t width(uint32_t value){
+        uint32_t bits = 0;
+        while(value >> bits) bits++;
+        return bits;
+    }
+    void append_bits(uint64_t& bit_pos, uint32_t value, uint32_t bits){
+        if(bits == 0) return;
+        size_t word = bit_pos >> 6;
+        uint32_t shift = bit_pos & 63;
+        if(word + 1 >= packed.size()) packed.resize(word + 2, 0);
+        packed[word] |= (uint64_t)value << shift;
+        if(shift + bits > 64) packed[word + 1] |= (uint64_t)value >> (64 - shift);
+        bit_pos += bits;
+    }
+    size_t slot(long long target) const { return (size_t)(target - min_target); }
+public:
+    static const int BLOCK_SIZE = 128;
+
+    //an index for `cards` cards from 1..max_value over targets [min_target, max_target]
+    TargetIndex(int arg1, int arg2, long long arg3, long long arg4){
+        cards = arg1;
+        max_value = arg2;
+        min_target = arg3;
+        max_target = arg4;
+        posting_start.assign(slot(max_target) + 2, 0);
+        block_start.assign(slot(max_target) + 2, 0);
+    }
+    int get_cards() const { return cards; }
+    int get_max_value() const { return max_value; }
+    long long get_min_target() const { return min_target; }
+    long long get_max_target() const { return max_target; }
+    bool covers(long long target) const { return target >= min_target && target <= max_target; }
+    uint32_t count(long long target) const {
+        if(!covers(target)) return 0;
+        return posting_start[slot(target) + 1] - posting_start[slot(target)];
+    }
+    size_t get_bytes() const {
+        return packed.size() * sizeof(uint64_t) + blocks.size() * sizeof(Block) + difficulties.size()
+             + (posting_start.size() + block_start.size()) * sizeof(uint32_t);
+    }
+
+    //must be called with a table over the same cards and values whose targets include these:
+    //a difficulty::DifficultyTable or an embedded::DifficultyView
+    template<class Table>
+    void build(const Table& table){
+        blocks.clear();
+        packed.assign(1, 0);
+        difficulties.clear();
+        uint64_t bit_pos = 0;
+        std::vector<uint32_t> ranks;
+        for(long long target = min_target; target <= max_target; target++){
+            size_t t = slot(target);
+            posting_start[t] = (uint32_t)difficulties.size();
+            block_start[t] = (uint32_t)blocks.size();
+            ranks.clear();
+            for(uint64_t rank = 0; rank < table.get_hands(); rank++){
+                uint8_t d = table.get(rank, target);
+                if(d == 0) continue;
+                ranks.push_back((uint32_t)rank);
+                difficulties.push_back(d);
+            }
+            for(size_t b = 0; b < ranks.size(); b += BLOCK_SIZE){
+                size_t end = std::min(ranks.size(), b + BLOCK_SIZE);
+                uint32_t bits = 0;
+                for(size_t i = b + 1; i < end; i++) bits = std::max(bits, width(ranks[i] - ranks[i - 1] - 1));
+                //blocks start on a word boundary so decoding never needs the previous block
+                bit_pos = (bit_pos + 63) & ~(uint64_t)63;
+                blocks.push_back(Block{ranks[b], (uint32_t)(bit_pos >> 6), bits});
+                for(size_t i = b + 1; i < end; i++) append_bits(bit_pos, ranks[i] - ranks[i - 1] - 1, bits);
+            }
+        }
+        posting_start[slot(max_target) + 1] = (uint32_t)difficulties.size();
+        block_start[slot(max_target) + 1] = (uint32_t)blocks.size();
+    }
+
+    //decodes block b of a list holding n postings into out; returns how many it held
+    int decode_block(uint32_t b, uint32_t first_block, uint32_t n, uint32_t* out) const {
+        const Block& block = blocks[b];
+        int size = (int)std::min<uint32_t>(BLOCK_SIZE, n - (b - first_block) * BLOCK_SIZE);
+        out[0] = block.first;
+        if(block.bits == 0){
+            for(int i = 1; i < size; i++) out[i] = out[i - 1] + 1;
+            return size;
+        }
+        uint64_t bit_pos = (uint64_t)block.word << 6;
+        uint64_t value_mask = block.bits == 64 ? ~0ULL : (1ULL << block.bits) - 1;
+        for(int i = 1; i < size; i++){
+            size_t word = bit_pos >> 6;
+            uint32_t shift = bit_pos & 63;
+            uint64_t v = packed[word] >> shift;
+            if(shift + block.bits > 64) v |= packed[word + 1] << (64 - shift);
+            out[i] = out[i - 1] + 1 + (uint32_t)(v & value_mask);
+            bit_pos += block.bits;
+        }
+        return size;
+    }
+
+    //walks one target's postings in rank order; seek skips whole blocks by their first rank
+    class Cursor{
+    private:
+        const TargetIndex* index;
+        uint32_t first_block;
+        uint32_t end_block;
+        uint32_t count;
+        uint32_t block;
+        int size;
+        int pos;
+        uint32_t buffer[BLOCK_SIZE];
+
+        void load(uint32_t b){
+            block = b;
+            pos = 0;
+            size = b < end_block ? index->decode_block(b, first_block, count, buffer) : 0;
+        }
+    public:
+        Cursor(const TargetIndex& arg1, long long target) : index(&arg1), first_block(0), end_block(0), count(0) {
+            if(index->covers(target)){
+                size_t t = index->slot(target);
+                first_block = index->block_start[t];
+                end_block = index->block_start[t + 1];
+                count = index->posting_start[t + 1] - index->posting_start[t];
+            }
+            load(first_block);
+        }
+        bool done() const { return pos >= size; }
+        uint32_t rank() const { return buffer[pos]; }
+        void next(){
+            if(++pos >= size && block + 1 < end_block) load(block + 1);
+        }
+        //moves to the first posting with rank >= target_rank
+        void seek(uint32_t target_rank){
+            if(done() || buffer[size - 1] < target_rank){
+                //gallop over the remaining block heads, then binary search the bracket
+                uint32_t lo = block + 1, step = 1;
+                while(lo + step < end_block && index->blocks[lo + step].first <= target_rank){ lo += step; step <<= 1; }
+                uint32_t hi = std::min(end_block, lo + step);
+                while(lo < hi){
+                    uint32_t mid = lo + (hi - lo) / 2;
+                    if(index->blocks[mid].first <= target_rank) lo = mid + 1;
+                    else hi = mid;
+                }
+                uint32_t b = lo > block + 1 ? lo - 1 : block + 1;
+                if(b >= end_block){ pos = size; return; }
+                load(b);
+            }
+            while(pos < size && buffer[pos] < target_rank) pos++;
+            if(pos >= size && block + 1 < end_block) load(block + 1);
+        }
+    };
+
+    //up to limit hands that make target with difficulty in [min_difficulty, max_difficulty],
+    //easiest first (or hardest first), ties in rank order
+    std::vector<Posting> hands_for(long long target, size_t limit, int min_difficulty = 1, int max_difficulty = 255,
+                                   bool hardest_first = false) const {
+        std::vector<Posting> found;
+        if(!covers(target)) return found;
+        uint32_t start = posting_start[slot(target)];
+        uint32_t n = count(target);
+        uint32_t per_score[256] = {};
+        for(uint32_t i = 0; i < n; i++) per_score[difficulties[start + i]]++;
+        //counting sort on difficulty; each bucket gets only the slots the limit leaves it
+        uint32_t next[256], end[256];
+        uint32_t taken = 0;
+        for(int k = 0; k < 256; k++){
+            int d = hardest_first ? 255 - k : k;
+            next[d] = end[d] = taken;
+            if(d < min_difficulty || d > max_difficulty) continue;
+            end[d] = taken += (uint32_t)std::min<size_t>(per_score[d], limit - taken);
+        }
+        found.resize(taken);
+        uint32_t buffer[BLOCK_SIZE];
+        uint32_t first_block = block_start[slot(target)];
+        uint32_t i = 0;
+        for(uint32_t b = first_block; b < block_start[slot(target) + 1]; b++){
+            int size = decode_block(b, first_block, n, buffer);
+            for(int k = 0; k < size; k++, i++){
+                uint8_t d = difficulties[start + i];
+                if(next[d] < end[d]) found[next[d]++] = Posting{buffer[k], d};
+            }
+        }
+        return found;
+    }
+
+    //hands that make every target in targets, in rank order
+    std::vector<uint32_t> intersect(std::vector<long long> targets) const {
+        std::vector<uint32_t> found;
+        if(targets.empty()) return found;
+        for(size_t i = 0; i < targets.size(); i++) if(count(targets[i]) == 0) return found;
+        std::sort(targets.begin(), targets.end(), [&](long long a, long long b){ return count(a) < count(b); });
+        std::vector<Cursor> cursors;
+        for(size_t i = 0; i < targets.size(); i++) cursors.emplace_back(*this, targets[i]);
+        Cursor& lead = cursors[0];
+        while(!lead.done()){
+            uint32_t candidate = lead.rank();
+            bool all = true;
+            for(size_t i = 1; i < cursors.size(); i++){
+                cursors[i].seek(candidate);
+                if(cursors[i].done()) return found;
+                if(cursors[i].rank() != candidate){
+                    all = false;
+                    lead.seek(cursors[i].rank());
+                    break;
+                }
+            }
+            if(all){
+                found.push_back(candidate);
+                lead.next();
+            }
+        }
+        return found;
+    }
+
+    bool save(const std::string& path) const {
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if(!f) return false;
+        long long header[7] = {cards, max_value, min_target, max_target,
+                               (long long)blocks.size(), (long long)packed.size(), (long long)difficulties.size()};
+        bool ok = std::fwrite("S24I", 1, 4, f) == 4
+               && std::fwrite(header, sizeof(header), 1, f) == 1
+               && std::fwrite(posting_start.data(), sizeof(uint32_t), posting_start.size(), f) == posting_start.size()
+               && std::fwrite(block_start.data(), sizeof(uint32_t), block_start.size(), f) == block_start.size()
+               && std::fwrite(blocks.data(), sizeof(Block), blocks.size(), f) == blocks.size()
+               && std::fwrite(packed.data(), sizeof(uint64_t), packed.size(), f) == packed.size()
+               && std::fwrite(difficulties.data(), 1, difficulties.size(), f) == difficulties.size();
+        return std::fclose(f) == 0 && ok;
+    }
+    //returns nullptr on a missing or malformed file
+    static TargetIndex* load(const std::string& path){
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if(!f) return nullptr;
+        char magic[4];
+        long long header[7];
+        TargetIndex* index = nullptr;
+        if(std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, "S24I", 4) == 0
+           && std::fread(header, sizeof(header), 1, f) == 1
+           && header[0] > 0 && header[0] <= 8 && header[1] > 0 && header[2] <= header[3]
+           && header[4] >= 0 && header[5] >= 0 && header[6] >= 0){
+            index = new TargetIndex((int)header[0], (int)header[1], header[2], header[3]);
+            index->blocks.resize((size_t)header[4]);
+            index->packed.resize((size_t)header[5]);
+            index->difficulties.resize((size_t)header[6]);
+            bool ok = std::fread(index->posting_start.data(), sizeof(uint32_t), index->posting_start.size(), f) == index->posting_start.size()
+                   && std::fread(index->block_start.data(), sizeof(uint32_t), index->block_start.size(), f) == index->block_start.size()
+                   && std::fread(index->blocks.data(), sizeof(Block), index->blocks.size(), f) == index->blocks.size()
+                   && std::fread(index->packed.data(), sizeof(uint64_t), index->packed.size(), f) == index->packed.size()
+                   && std::fread(index->difficulties.data(), 1, index->difficulties.size(), f) == index->difficulties.size();
+            if(!ok){
+                delete index;
+                index = nullptr;
+            }
+        }
+        std::fclose(f);
+        return index;
+    }
+};
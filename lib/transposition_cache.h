@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "huge_pages.h"
+
+//memo for solution_exists on intermediate states. a state is the sorted
+//multiset of remaining values plus the target; it is stored as a 64-bit
+//fingerprint of the exact double bit patterns, so two routes to the same
+//state only share an entry when they produced bitwise identical values.
+//buckets are one cache line of 8 entries; bit 0 of an entry is the verdict
+class TranspositionCache{
+private:
+    HugePageArray<uint64_t> entries;
+    uint64_t bucket_mask;
+    uint64_t hits;
+    uint64_t misses;
+
+    static uint64_t mix(uint64_t h){
+        h ^= h >> 33; h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33; h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+public:
+    //capacity is rounded up to a power of two number of 8-entry buckets
+    explicit TranspositionCache(size_t capacity){
+        size_t buckets = 1;
+        while(buckets * 8 < capacity) buckets <<= 1;
+        entries.resize(buckets * 8);
+        bucket_mask = buckets - 1;
+        hits = 0;
+        misses = 0;
+    }
+
+    static uint64_t fingerprint(const std::vector<double>& nums, double target){
+        return fingerprint(nums.data(), nums.size(), target);
+    }
+    static uint64_t fingerprint(const double* nums, size_t count, double target){
+        //every value is hashed; past 16 the sort copy goes to the heap
+        double small[16];
+        std::vector<double> large;
+        double* sorted = small;
+        if(count > 16){
+            large.resize(count);
+            sorted = large.data();
+        }
+        std::copy(nums, nums + count, sorted);
+        std::sort(sorted, sorted + count);
+        uint64_t h = mix(count * 0x9E3779B97F4A7C15ULL);
+        uint64_t bits;
+        for(size_t i = 0; i < count; i++){
+            std::memcpy(&bits, &sorted[i], sizeof(bits));
+            h = mix(h ^ bits);
+        }
+        std::memcpy(&bits, &target, sizeof(bits));
+        return mix(h ^ bits) | (1ULL << 63);
+    }
+
+    //returns true and sets result when the state was seen before
+    bool lookup(uint64_t key, bool& result){
+        const uint64_t* bucket = entries.data() + (key & bucket_mask) * 8;
+        for(int i = 0; i < 8; i++){
+            if((bucket[i] | 1) == (key | 1)){
+                result = bucket[i] & 1;
+                hits++;
+                return true;
+            }
+        }
+        misses++;
+        return false;
+    }
+    void store(uint64_t key, bool result){
+        uint64_t* bucket = entries.data() + (key & bucket_mask) * 8;
+        int slot = (int)((key >> 40) & 7);
+        for(int i = 0; i < 8; i++){
+            if(bucket[i] == 0){ slot = i; break; }
+        }
+        bucket[slot] = (key & ~1ULL) | (result ? 1 : 0);
+    }
+
+    uint64_t get_hits() const { return hits; }
+    uint64_t get_misses() const { return misses; }
+    size_t get_bytes() const { return entries.bytes(); }
+    HugePageMode get_mode() const { return entries.mode(); }
+};
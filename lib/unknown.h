@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "rational.h"
+#include "reachable.h"
+
+//"which x makes the target?" for a hand with one unknown number. x sits in exactly one
+//leaf of any expression, so every expression is a mobius form (a x + b) / (c x + d) in x:
+//combining a form with a known value (+ - * / either way) gives another form. forms are
+//built per subset of the known numbers from the reach:: value tables, each subset once,
+//and every full-hand form equal to the target is solved for x directly, so the work does
+//not depend on which x values are allowed. each form carries its poles, the x values at
+//which some step divided by zero, and a solution there is dropped
+namespace unknown{
+
+//a step adds at most one pole, so this many known numbers never overflow a form's poles
+const size_t MAX_KNOWN = 6;
+
+struct Form{
+    Rational a;
+    Rational b;
+    Rational c;
+    Rational d;
+    uint8_t poles;
+    Rational pole[MAX_KNOWN];
+
+    bool defined_at(const Rational& x) const { return !std::binary_search(pole, pole + poles, x); }
+    void add_pole(const Rational& x){
+        Rational* at = std::lower_bound(pole, pole + poles, x);
+        if(at != pole + poles && *at == x) return;
+        std::copy_backward(at, pole + poles, pole + poles + 1);
+        *at = x;
+        poles++;
+    }
+    //equal functions built two ways are defined wherever either one is
+    void merge_poles(const Form& other){
+        poles = (uint8_t)(std::set_intersection(pole, pole + poles, other.pole, other.pole + other.poles, pole) - pole);
+    }
+};
+
+inline bool same_function(const Form& p, const Form& q){ return p.a == q.a && p.b == q.b && p.c == q.c && p.d == q.d; }
+inline bool operator<(const Form& p, const Form& q){
+    if(p.a != q.a) return p.a < q.a;
+    if(p.b != q.b) return p.b < q.b;
+    if(p.c != q.c) return p.c < q.c;
+    return p.d < q.d;
+}
+
+//scales so the first non-zero of c, d is 1, which makes equal functions equal forms
+inline bool normalize(Form& f){
+    const Rational& lead = f.c.num != 0 ? f.c : f.d;
+    if(lead.num == 0) return false;
+    if(lead == Rational(1)) return true;
+    Rational s = lead;
+    return div(f.a, s, f.a) && div(f.b, s, f.b) && div(f.c, s, f.c) && div(f.d, s, f.d);
+}
+
+//calls visit(form) for f + v, f - v, v - f, f * v, f / v and v / f; overflowing ones are skipped
+template<class Visit>
+inline void for_each_combination(const Form& f, const Rational& v, Visit&& visit){
+    Form g = f;
+    Rational t;
+    if(mul(v, f.c, t) && add(f.a, t, g.a) && mul(v, f.d, t) && add(f.b, t, g.b)) visit(g);
+    if(mul(v, f.c, t) && sub(f.a, t, g.a) && mul(v, f.d, t) && sub(f.b, t, g.b)) visit(g);
+    if(mul(v, f.c, t) && sub(t, f.a, g.a) && mul(v, f.d, t) && sub(t, f.b, g.b)) visit(g);
+    g.a = f.a;
+    g.b = f.b;
+    if(mul(f.a, v, g.a) && mul(f.b, v, g.b)) visit(g);
+    g.a = f.a;
+    g.b = f.b;
+    if(v.num != 0 && mul(f.c, v, g.c) && mul(f.d, v, g.d)) visit(g);
+    //v / f divides by zero where f's numerator a x + b is zero
+    if((f.a.num != 0 || f.b.num != 0) && mul(f.c, v, g.a) && mul(f.d, v, g.b)){
+        g.c = f.a;
+        g.d = f.b;
+        Rational root;
+        if(f.a.num != 0){
+            if(!div(f.b, f.a, root) || !sub(Rational(0), root, root)) return;
+            g.add_pole(root);
+        }
+        visit(g);
+    }
+}
+
+struct Answer{
+    //every exact x that reaches the target, ascending
+    std::vector<Rational> values;
+    //the target is reached for every x (e.g. 0 * x + 24) other than the ones in except
+    bool any;
+    std::vector<Rational> except;
+};
+
+inline Answer solve(const std::vector<Rational>& known, const Rational& target){
+    Answer answer;
+    answer.any = false;
+    size_t n = known.size();
+    if(n > MAX_KNOWN) return answer;
+    uint32_t full = (1u << n) - 1;
+    std::vector<reach::ValueSet> values = n > 0 ? reach::subset_tables(known) : std::vector<reach::ValueSet>(1);
+    //forms[mask]: every form of x combined with exactly the known numbers in mask
+    std::vector<std::vector<Form>> forms(full + 1);
+    Form x;
+    x.a = Rational(1);
+    x.b = Rational(0);
+    x.c = Rational(0);
+    x.d = Rational(1);
+    x.poles = 0;
+    forms[0].push_back(x);
+    for(uint32_t mask = 1; mask <= full; mask++){
+        std::vector<Form>& out = forms[mask];
+        //x's side takes any proper subset (maybe empty), the other side the non-empty rest
+        for(uint32_t side = mask; ; side = (side - 1) & mask){
+            if(side != mask){
+                const reach::ValueSet& other = values[mask ^ side];
+                for(size_t i = 0; i < forms[side].size(); i++)
+                    for(size_t j = 0; j < other.size(); j++)
+                        for_each_combination(forms[side][i], other[j], [&](Form f){ if(normalize(f)) out.push_back(f); });
+            }
+            if(side == 0) break;
+        }
+        std::sort(out.begin(), out.end());
+        size_t kept = 0;
+        for(size_t i = 0; i < out.size(); i++){
+            if(kept > 0 && same_function(out[kept - 1], out[i])) out[kept - 1].merge_poles(out[i]);
+            else out[kept++] = out[i];
+        }
+        out.resize(kept);
+    }
+    //(a x + b) / (c x + d) = t  <=>  (a - t c) x = t d - b
+    bool constant = false;
+    Form everywhere;
+    const std::vector<Form>& top = forms[full];
+    for(size_t i = 0; i < top.size(); i++){
+        const Form& f = top[i];
+        Rational tc, td, lhs, rhs, root;
+        if(!mul(target, f.c, tc) || !mul(target, f.d, td) || !sub(f.a, tc, lhs) || !sub(td, f.b, rhs)) continue;
+        if(lhs.num == 0){
+            if(rhs.num != 0) continue;
+            if(constant) everywhere.merge_poles(f);
+            else everywhere = f;
+            constant = true;
+        }
+        else if(div(rhs, lhs, root) && f.defined_at(root)) answer.values.push_back(root);
+    }
+    reach::sort_unique(answer.values);
+    if(constant){
+        answer.any = true;
+        for(uint8_t i = 0; i < everywhere.poles; i++)
+            if(!std::binary_search(answer.values.begin(), answer.values.end(), everywhere.pole[i])) answer.except.push_back(everywhere.pole[i]);
+    }
+    return answer;
+}
+
+inline Answer solve(const std::vector<int>& known, long long target){
+    return solve(reach::to_rationals(known), Rational(target));
+}
+
+}
@@ -6,9 +6,11 @@ from kivy.uix.button import Button
 from kivy.vector import Vector
 from kivy.clock import Clock
 from kivy.animation import Animation
+from kivy.logger import Logger
 from random import randint 
 from copy import copy
 from kivy.uix.floatlayout import FloatLayout
+from prefetch import HandPrefetcher
 
 #Note about the code: For Numberpanel and OperationPanel, the floatlayout is within the widget. 
 #Thus, use self.parent.parent to access outermost layer
@@ -22,6 +24,8 @@ class Solve24Game(Widget):
     timelabel = ObjectProperty(None)
     scorelabel = ObjectProperty(None)
     targetlabel = ObjectProperty(None)
+    prefetcher = None
+    current_hand = None
     
     def timer_tick(self, dt=None):
         self.time_passed = self.time_passed + 1
@@ -35,7 +39,11 @@ class Solve24Game(Widget):
         self.main_numberpanel = new_numberpanel
         self.time_passed = 0
         self.timelabel.time_remaining = self.time_duration
-        self.main_numberpanel.start()
+        #a hand the prefetcher already solved, or a random draw if none is ready
+        self.current_hand = self.prefetcher.next_hand()
+        if self.current_hand is None:
+            Logger.info('Prefetch: no prepared hand ready, drawing a random one')
+        self.main_numberpanel.start(self.current_hand.numbers if self.current_hand is not None else None)
         self.bind(remaining_nums=self.finishedgame_callback)
         self.bind(time_passed=self.out_of_time)
         self.ops_state = "None"
@@ -137,11 +145,13 @@ class NumberPanel(Widget):
         self.ids[block_id].remove_operation()
         self.first_operation = "None"
 
-    def start(self):
-        self.number1.generate_value()
-        self.number2.generate_value()
-        self.number3.generate_value()
-        self.number4.generate_value()
+    def start(self, values=None):
+        if values is None:
+            values = [None, None, None, None]
+        self.number1.generate_value(values[0])
+        self.number2.generate_value(values[1])
+        self.number3.generate_value(values[2])
+        self.number4.generate_value(values[3])
         self.remaining_nums = 4
     
     def compute(self, block_instance):
@@ -205,8 +215,9 @@ class NumberBlock(Button, Widget):
         self.parent.parent.add_first_op(self)
         self.activated = True
     
-    def generate_value(self):
-        value = randint(1, 13)
+    def generate_value(self, value=None):
+        if value is None:
+            value = randint(1, 13)
         self.text = str(value)
         self.int_value = value
         self.disabled = False
@@ -258,9 +269,16 @@ class NumberBlock(Button, Widget):
 class Solve24App(App):
     def build(self):
         game = Solve24Game()
+        #started with the game, and given a moment, so the first round is a prepared hand too
+        game.prefetcher = HandPrefetcher(target=game.targetlabel.target_number)
+        game.prefetcher.wait_started(1)
         game.start_state()
         Clock.schedule_interval(game.timer_tick, 1)
+        self.game = game
         return game
+
+    def on_stop(self):
+        self.game.prefetcher.close()
     
 if __name__ == '__main__':
     Solve24App().run()
@@ -0,0 +1,109 @@
+import logging
+import os
+import subprocess
+import sys
+import threading
+from queue import Queue, Empty
+
+#Keeps upcoming hands ready in a background solver process (solve_24 prefetch),
+#so a new round only takes an already-solved hand off a queue and never waits on the solver
+
+log = logging.getLogger('prefetch')
+
+#build/ is where make puts the solver; the copies next to the sources are older prebuilt ones
+def solver_path():
+    name = 'solve_24.exe' if sys.platform.startswith('win') else 'solve_24'
+    here = os.path.dirname(os.path.abspath(__file__))
+    for folder in (os.path.join(here, '..', 'build'), here, os.path.join(here, '..', 'lib')):
+        path = os.path.join(folder, name)
+        if os.path.isfile(path):
+            return path
+    return None
+
+class PreparedHand:
+    def __init__(self, numbers, target, difficulty, solution):
+        self.numbers = numbers
+        self.target = target
+        self.difficulty = difficulty
+        self.solution = solution
+
+def parse_hand(line):
+    parts = line.strip().split(' | ')
+    if len(parts) != 4:
+        return None
+    try:
+        return PreparedHand([int(n) for n in parts[0].split()], int(parts[1]), int(parts[2]), parts[3])
+    except ValueError:
+        return None
+
+class HandPrefetcher:
+    def __init__(self, cards=4, target=24, depth=4):
+        self.ready = Queue()
+        self.lock = threading.Lock()
+        self.started = threading.Event()
+        self.process = None
+        path = solver_path()
+        if path is None:
+            log.warning('no solve_24 binary found (run make); hands will be random draws')
+            self.started.set()
+            return
+        try:
+            self.process = subprocess.Popen([path, 'prefetch', '--cards', str(cards), '--target', str(target),
+                                             '--depth', str(depth), '--seed', str(int.from_bytes(os.urandom(4), 'little'))],
+                                            stdin=subprocess.PIPE, stdout=subprocess.PIPE, universal_newlines=True, bufsize=1)
+        except OSError as error:
+            log.warning('could not start %s: %s; hands will be random draws', path, error)
+            self.process = None
+            self.started.set()
+            return
+        threading.Thread(target=self.read_hands, args=(self.process,), daemon=True).start()
+        for i in range(depth):
+            self.request()
+
+    #blocks until the first hand is ready or the solver is known to be unavailable, at most timeout seconds
+    def wait_started(self, timeout):
+        return self.started.wait(timeout)
+
+    def request(self):
+        with self.lock:
+            if self.process is None:
+                return
+            try:
+                self.process.stdin.write('next\n')
+                self.process.stdin.flush()
+            except (OSError, ValueError) as error:
+                log.warning('solver process stopped taking requests: %s', error)
+                self.process = None
+
+    def read_hands(self, process):
+        for line in process.stdout:
+            #the solver gave up: no hand it drew makes the target
+            if line.strip() == 'none':
+                log.warning('solver found no playable hand; hands will be random draws')
+                self.close()
+                break
+            hand = parse_hand(line)
+            if hand is not None:
+                self.ready.put(hand)
+                self.started.set()
+        self.started.set()
+        if self.process is process:
+            log.warning('solver process exited with status %s', process.wait())
+
+    #next prepared hand, or None when none is ready yet (the caller falls back to a random draw)
+    def next_hand(self):
+        try:
+            hand = self.ready.get_nowait()
+        except Empty:
+            return None
+        self.request()
+        return hand
+
+    def close(self):
+        with self.lock:
+            if self.process is not None:
+                try:
+                    self.process.stdin.close()
+                except OSError:
+                    pass
+                self.process = None
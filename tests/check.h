@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+//minimal checks for the tests/ programs: CHECK records a failure and carries on, and
+//test_exit() is what main returns (non-zero after any failure), so make test stops there
+inline int& test_failures(){
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) \
+    do{ \
+        if(!(condition)){ \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            test_failures()++; \
+        } \
+    }while(0)
+
+inline int test_exit(const char* name){
+    if(test_failures()) std::fprintf(stderr, "%s: %d failed\n", name, test_failures());
+    else std::printf("%s: ok\n", name);
+    return test_failures() ? 1 : 0;
+}
+
+inline uint64_t test_rng(uint64_t& state){
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <vector>
+#include "../lib/solver.h"
+#include "check.h"
+
+//solutions in Solver's order (pairs i < j, a+b a*b a-b a/b b-a b/a) whose every step meets spec
+//and that use every required operator, by plain recursion with the spec applied at the leaves
+static long long brute_count(const std::vector<double>& nums, double target, const FilterSpec& spec, unsigned used, bool clean){
+    if(nums.size() == 1)
+        return clean && std::fabs(nums[0] - target) < 1e-8 && (spec.required & ~used) == 0 ? 1 : 0;
+    long long total = 0;
+    for(size_t i = 0; i + 1 < nums.size(); i++){
+        for(size_t j = i + 1; j < nums.size(); j++){
+            std::vector<double> rest;
+            for(size_t k = 0; k < nums.size(); k++)
+                if(k != i && k != j) rest.push_back(nums[k]);
+            double a = nums[i], b = nums[j];
+            const double values[] = {a + b, a * b, a - b, a / b, b - a, b / a};
+            const char ops[] = "+*-/-/";
+            for(int o = 0; o < 6; o++){
+                if(!(spec.ops & op_bit(ops[o]))) continue;
+                double value = values[o];
+                bool ok = clean && !(spec.whole && std::fabs(value - std::round(value)) > 1e-8) && !(spec.non_negative && value < -1e-8);
+                rest.push_back(value);
+                total += brute_count(rest, target, spec, used | op_bit(ops[o]), ok);
+                rest.pop_back();
+            }
+        }
+    }
+    return total;
+}
+
+//a stored solution replays to target using only what spec allows
+static bool meets(const SolveStep* steps, size_t count, double target, const FilterSpec& spec){
+    unsigned used = 0;
+    for(size_t k = 0; k < count; k++){
+        const SolveStep& s = steps[k];
+        if(!(spec.ops & op_bit(s.op))) return false;
+        if(spec.whole && std::fabs(s.result - std::round(s.result)) > 1e-8) return false;
+        if(spec.non_negative && s.result < -1e-8) return false;
+        used |= op_bit(s.op);
+    }
+    return (spec.required & ~used) == 0 && count > 0 && std::fabs(steps[count - 1].result - target) < 1e-8;
+}
+
+int main(){
+    Solver solver;
+    SolveContext context;
+    uint64_t state = 7;
+    for(int round = 0; round < 400; round++){
+        std::vector<int> hand;
+        std::vector<double> values;
+        int n = 3 + (int)(test_rng(state) % 2);
+        for(int i = 0; i < n; i++){
+            hand.push_back(1 + (int)(test_rng(state) % 13));
+            values.push_back(hand.back());
+        }
+        FilterSpec spec;
+        do spec.ops = (unsigned)(test_rng(state) % 16); while(spec.ops == 0);
+        spec.required = (unsigned)(test_rng(state) % 16) & (test_rng(state) % 2 ? spec.ops : 15);
+        spec.whole = test_rng(state) % 2;
+        spec.non_negative = test_rng(state) % 2;
+        double target = round % 2 ? 24 : (double)(1 + test_rng(state) % 30);
+
+        long long expected = brute_count(values, target, spec, 0, true);
+        CHECK(solver.count(context, hand, target, spec) == expected);
+        CHECK(solver.is_solvable(context, hand, target, spec) == (expected > 0));
+        bool found = solver.find_first(context, hand, target, spec);
+        CHECK(found == (expected > 0));
+        if(found) CHECK(meets(context.solution(0), context.get_steps_per_solution(), target, spec));
+        if(solver.find_best(context, hand, target, 3, CostModel(), spec) > 0)
+            CHECK(expected > 0 && meets(context.solution(0), context.get_steps_per_solution(), target, spec));
+        else CHECK(expected == 0);
+    }
+    return test_exit("constrained_test");
+}
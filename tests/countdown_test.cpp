@@ -0,0 +1,60 @@
+#include <set>
+#include <vector>
+#include "../lib/countdown.h"
+#include "check.h"
+
+//every value countdown rules allow from any non-empty subset of numbers, by plain recursion
+static void reachable(std::vector<long long> numbers, std::set<long long>& out){
+    for(size_t i = 0; i < numbers.size(); i++) out.insert(numbers[i]);
+    for(size_t i = 0; i < numbers.size(); i++){
+        for(size_t j = 0; j < numbers.size(); j++){
+            if(i == j) continue;
+            long long a = numbers[i], b = numbers[j];
+            std::vector<long long> rest;
+            for(size_t k = 0; k < numbers.size(); k++)
+                if(k != i && k != j) rest.push_back(numbers[k]);
+            std::vector<long long> made;
+            if(i < j) made.push_back(a + b);
+            if(i < j) made.push_back(a * b);
+            if(a > b) made.push_back(a - b);
+            if(b > 1 && a % b == 0) made.push_back(a / b);
+            for(size_t m = 0; m < made.size(); m++){
+                rest.push_back(made[m]);
+                reachable(rest, out);
+                rest.pop_back();
+            }
+        }
+    }
+}
+
+int main(){
+    //targets <= 0 have no answer; 0 used to divide by zero and -5 to come out "exact"
+    countdown::Solver small({1, 2, 3});
+    countdown::Result none = small.solve(0);
+    CHECK(!none.exact && none.mask == 0 && none.expression.empty());
+    none = small.solve(-5);
+    CHECK(!none.exact && none.mask == 0 && none.expression.empty());
+
+    uint64_t state = 12345;
+    for(int round = 0; round < 200; round++){
+        std::vector<int> hand;
+        std::vector<long long> values;
+        int n = 2 + (int)(test_rng(state) % 4);
+        for(int i = 0; i < n; i++){
+            hand.push_back(1 + (int)(test_rng(state) % 25));
+            values.push_back(hand.back());
+        }
+        std::set<long long> all;
+        reachable(values, all);
+        long long target = 1 + (long long)(test_rng(state) % 999);
+        countdown::Solver solver(hand);
+        countdown::Result result = solver.solve(target);
+        CHECK(result.exact == (all.count(target) > 0));
+        long long best = -1;
+        for(std::set<long long>::iterator it = all.begin(); it != all.end(); ++it)
+            if(best < 0 || std::llabs(*it - target) < std::llabs(best - target)) best = *it;
+        CHECK(std::llabs(result.value - target) == std::llabs(best - target));
+        CHECK(all.count(result.value) > 0);
+    }
+    return test_exit("countdown_test");
+}
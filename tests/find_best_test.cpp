@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+#include "../lib/solver.h"
+#include "check.h"
+
+//a value being built: its expression (operands of + and * in a fixed order), summed step
+//costs and tree height
+struct Item{
+    double value;
+    std::string key;
+    double cost;
+    int height;
+};
+
+static std::string number_key(double v){
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", v);
+    return text;
+}
+
+//cheapest cost of every distinct expression tree over items that equals target
+static void all_trees(const std::vector<Item>& items, double target, const CostModel& cost, std::map<std::string, double>& out){
+    if(items.size() == 1){
+        if(std::fabs(items[0].value - target) < 1e-8){
+            double total = items[0].cost + cost.height * items[0].height;
+            std::map<std::string, double>::iterator it = out.find(items[0].key);
+            if(it == out.end() || total < it->second) out[items[0].key] = total;
+        }
+        return;
+    }
+    for(size_t i = 0; i < items.size(); i++){
+        for(size_t j = 0; j < items.size(); j++){
+            if(i == j) continue;
+            std::vector<Item> rest;
+            for(size_t k = 0; k < items.size(); k++)
+                if(k != i && k != j) rest.push_back(items[k]);
+            const Item& a = items[i];
+            const Item& b = items[j];
+            const char ops[] = "+*-/";
+            for(int o = 0; o < 4; o++){
+                char op = ops[o];
+                if((op == '+' || op == '*') && i > j) continue;
+                double value = op == '+' ? a.value + b.value : op == '*' ? a.value * b.value : op == '-' ? a.value - b.value : a.value / b.value;
+                std::string left = a.key, right = b.key;
+                if((op == '+' || op == '*') && right < left) std::swap(left, right);
+                SolveStep step{a.value, b.value, value, op};
+                rest.push_back(Item{value, "(" + left + op + right + ")", a.cost + b.cost + cost.step(step), std::max(a.height, b.height) + 1});
+                all_trees(rest, target, cost, out);
+                rest.pop_back();
+            }
+        }
+    }
+}
+
+static void check_hand(const Solver& solver, SolveContext& context, const std::vector<int>& hand, double target, size_t top){
+    CostModel cost;
+    std::vector<Item> items;
+    for(size_t i = 0; i < hand.size(); i++) items.push_back(Item{(double)hand[i], number_key(hand[i]), 0, 0});
+    std::map<std::string, double> trees;
+    all_trees(items, target, cost, trees);
+    std::vector<double> expected;
+    for(std::map<std::string, double>::iterator it = trees.begin(); it != trees.end(); ++it) expected.push_back(it->second);
+    std::sort(expected.begin(), expected.end());
+    if(expected.size() > top) expected.resize(top);
+    size_t kept = solver.find_best(context, hand, target, top, cost);
+    CHECK(kept == expected.size());
+    for(size_t i = 0; i < kept && i < expected.size(); i++){
+        if(std::fabs(context.solution_cost(i) - expected[i]) > 1e-9){
+            std::fprintf(stderr, "hand");
+            for(size_t k = 0; k < hand.size(); k++) std::fprintf(stderr, " %d", hand[k]);
+            std::fprintf(stderr, " -> %g: cost %zu is %g, brute force %g\n", target, i, context.solution_cost(i), expected[i]);
+        }
+        CHECK(std::fabs(context.solution_cost(i) - expected[i]) < 1e-9);
+    }
+}
+
+int main(){
+    Solver solver;
+    SolveContext context;
+    //an intermediate equal to a number of the hand: (13 * 2) - (8 / 4) and ((8 / 4) * 13) - 2
+    //are different trees and both belong in the top three
+    check_hand(solver, context, {2, 13, 8, 4}, 24, 3);
+    check_hand(solver, context, {1, 11, 1, 11}, 24, 5);
+    uint64_t state = 99;
+    for(int round = 0; round < 300; round++){
+        std::vector<int> hand;
+        int n = 4 + (int)(test_rng(state) % 2);
+        for(int i = 0; i < n; i++) hand.push_back(1 + (int)(test_rng(state) % 13));
+        check_hand(solver, context, hand, 24, 1 + test_rng(state) % 5);
+    }
+    return test_exit("find_best_test");
+}
@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "../lib/replay.h"
+#include "../lib/solver.h"
+#include "check.h"
+
+static SolveRequest request_from(const std::string& line){
+    std::istringstream in(line);
+    SolveRequest request;
+    CHECK(parse_request(in, request));
+    return request;
+}
+
+int main(){
+    //request lines, and whether the hand makes the target
+    const char* lines[] = {"exists 1/3 1 3", "exists 1234567 1234566 1", "exists 1234567 1234568 3",
+                           "exists 2000000 1000000 2", "exists 7/10 1/5 1/2", "exists -5/2 1/2 3", "exists 24 1/3 1/3 1/3 23",
+                           "exists 1 1000000001/1000000000 1"};
+    //the last is 1e-9 off target: only an exact search tells it apart
+    const bool solvable[] = {true, true, false, true, true, true, true, false};
+    const size_t count = sizeof(lines) / sizeof(lines[0]);
+
+    //the target is kept and written exactly, so a capture replays the same queries
+    std::string path = "/tmp/request_log_test_" + std::to_string((long long)getpid()) + ".txt";
+    CaptureWriter writer;
+    CHECK(writer.open(path));
+    std::vector<SolveRequest> sent;
+    for(size_t i = 0; i < count; i++){
+        sent.push_back(request_from(lines[i]));
+        writer.write(sent.back());
+    }
+    writer.flush();
+    std::vector<SolveRequest> read;
+    CHECK(read_capture(path, read));
+    std::remove(path.c_str());
+    CHECK(read.size() == count);
+    for(size_t i = 0; i < read.size() && i < count; i++){
+        CHECK(read[i].target == sent[i].target);
+        CHECK(read[i].numbers == sent[i].numbers);
+        CHECK(format_request(read[i]) == lines[i]);
+    }
+    CHECK(format_request(sent[0]).find("1/3") != std::string::npos);
+    CHECK(format_request(sent[1]).find("1234567") != std::string::npos);
+
+    //replaying the capture gets the same answers as the requests it was written from
+    std::vector<int> answers(count, -1);
+    Solver solver;
+    SolveContext context;
+    ReplayReport report = replay(read, ReplayOptions(), [&](int){
+        return [&](const SolveRequest& request){
+            for(size_t i = 0; i < count; i++)
+                if(&request == &read[i]) answers[i] = solver.is_solvable(context, request.numbers, request.target) ? 1 : 0;
+            return true;
+        };
+    });
+    CHECK(report.requests == count && report.failed == 0);
+    for(size_t i = 0; i < count; i++) CHECK(answers[i] == (solvable[i] ? 1 : 0));
+
+    //targets written through a double by older captures: whole numbers still read, rounded fractions do not
+    SolveRequest old;
+    std::istringstream large("exists 2e+06 1000000 2");
+    CHECK(parse_request(large, old) && old.target == Rational(2000000));
+    std::istringstream rounded("exists 3.33333e-01 1 3");
+    CHECK(!parse_request(rounded, old));
+    return test_exit("request_log_test");
+}
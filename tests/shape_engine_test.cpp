@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+#include "../lib/shape_engine.h"
+#include "check.h"
+
+typedef std::map<std::string, double> Expressions;
+
+static std::string number_text(double v){
+    char text[32];
+    std::snprintf(text, sizeof(text), "%g", v);
+    return text;
+}
+
+//every tree over leaves[lo, hi) in their order, as describe() would print it (with the outer
+//parentheses) and its value; ops are + - * / and, with reversals, b - a and b / a
+static std::vector<std::pair<std::string, double> > trees(const std::vector<double>& leaves, size_t lo, size_t hi, bool reversals){
+    std::vector<std::pair<std::string, double> > out;
+    if(hi - lo == 1){
+        out.push_back(std::make_pair(number_text(leaves[lo]), leaves[lo]));
+        return out;
+    }
+    const char symbols[] = "+-*/-/";
+    for(size_t split = lo + 1; split < hi; split++){
+        std::vector<std::pair<std::string, double> > lefts = trees(leaves, lo, split, reversals);
+        std::vector<std::pair<std::string, double> > rights = trees(leaves, split, hi, reversals);
+        for(size_t a = 0; a < lefts.size(); a++){
+            for(size_t b = 0; b < rights.size(); b++){
+                for(int op = 0; op < (reversals ? shapes::OPS_WITH_REVERSALS : shapes::OPS); op++){
+                    const std::string& l = lefts[a].first;
+                    const std::string& r = rights[b].first;
+                    std::string text = op < shapes::OPS ? "(" + l + " " + symbols[op] + " " + r + ")" : "(" + r + " " + symbols[op] + " " + l + ")";
+                    out.push_back(std::make_pair(text, shapes::apply(op, lefts[a].second, rights[b].second)));
+                }
+            }
+        }
+    }
+    return out;
+}
+
+static std::string strip(const std::string& text){
+    return text[0] == '(' ? text.substr(1, text.size() - 2) : text;
+}
+
+static bool same_value(double a, double b){
+    if(std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+    return a == b || std::fabs(a - b) < 1e-9;
+}
+
+//for_each_expression visits each expression over a hand exactly once, with its value
+static void check_hand(shapes::ExpressionEngine& engine, std::vector<double> hand, double target){
+    Expressions expected;
+    std::sort(hand.begin(), hand.end());
+    do{
+        std::vector<std::pair<std::string, double> > all = trees(hand, 0, hand.size(), false);
+        for(size_t i = 0; i < all.size(); i++) expected[strip(all[i].first)] = all[i].second;
+    }while(std::next_permutation(hand.begin(), hand.end()));
+
+    Expressions seen;
+    long long visits = 0, hits = 0;
+    uint64_t before = engine.get_evaluations();
+    engine.for_each_expression(hand.data(), (int)hand.size(), [&](double value){
+        std::string text = engine.describe();
+        visits++;
+        CHECK(seen.count(text) == 0);
+        seen[text] = value;
+        Expressions::iterator it = expected.find(text);
+        CHECK(it != expected.end() && same_value(it->second, value));
+        return false;
+    });
+    CHECK(visits == (long long)expected.size());
+    //the gray walk recomputes about one node per expression, well under a full evaluation
+    if(hand.size() >= 4) CHECK(engine.get_evaluations() - before < 2 * (uint64_t)visits);
+    for(Expressions::iterator it = expected.begin(); it != expected.end(); ++it) hits += std::fabs(it->second - target) < 1e-8;
+    CHECK(engine.count(hand.data(), (int)hand.size(), target) == hits);
+}
+
+//for_each_assignment with reversals covers every operator and child order of one shape
+static void check_assignments(shapes::ExpressionEngine& engine, const std::vector<double>& ordered){
+    int n = (int)ordered.size();
+    std::vector<std::pair<std::string, double> > all = trees(ordered, 0, n, true);
+    Expressions expected;
+    for(size_t i = 0; i < all.size(); i++) expected[strip(all[i].first)] = all[i].second;
+    const std::vector<shapes::Shape>& shapes_n = shapes::shapes_for(n);
+    Expressions seen;
+    long long visits = 0, per_shape = 1;
+    for(int k = 1; k < n; k++) per_shape *= shapes::OPS_WITH_REVERSALS;
+    for(size_t s = 0; s < shapes_n.size(); s++){
+        long long before = visits;
+        engine.for_each_assignment(shapes_n[s], ordered.data(), true, [&](double value){
+            std::string text = engine.describe();
+            visits++;
+            seen[text] = value;
+            Expressions::iterator it = expected.find(text);
+            CHECK(it != expected.end() && same_value(it->second, value));
+            return false;
+        });
+        CHECK(visits - before == per_shape);
+    }
+    //distinct leaves: every assignment prints differently, so nothing was visited twice
+    CHECK(seen.size() == expected.size() && visits == (long long)expected.size());
+}
+
+int main(){
+    long long catalan = 1;
+    for(int n = 1; n <= shapes::MAX_LEAVES; n++){
+        CHECK((long long)shapes::shapes_for(n).size() == catalan);
+        catalan = catalan * 2 * (2 * n - 1) / (n + 1);
+    }
+
+    shapes::ExpressionEngine engine;
+    check_hand(engine, {8, 3, 8, 3}, 24);
+    check_hand(engine, {1, 1, 1, 1}, 4);
+    check_assignments(engine, {1, 2, 3, 5});
+    check_assignments(engine, {7, 4, 9});
+    uint64_t state = 31;
+    for(int round = 0; round < 25; round++){
+        std::vector<double> hand;
+        int n = 1 + (int)(test_rng(state) % 5);
+        for(int i = 0; i < n; i++) hand.push_back((double)(test_rng(state) % 7));
+        check_hand(engine, hand, 24);
+    }
+    return test_exit("shape_engine_test");
+}
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <vector>
+#include "../lib/unknown.h"
+#include "check.h"
+
+//whether some expression over nums makes target exactly, by plain pairwise recursion;
+//a step that divides by zero or overflows is dropped
+static bool reaches(const std::vector<Rational>& nums, const Rational& target){
+    if(nums.size() == 1) return nums[0] == target;
+    for(size_t i = 0; i + 1 < nums.size(); i++){
+        for(size_t j = i + 1; j < nums.size(); j++){
+            std::vector<Rational> rest;
+            for(size_t k = 0; k < nums.size(); k++)
+                if(k != i && k != j) rest.push_back(nums[k]);
+            const Rational& a = nums[i];
+            const Rational& b = nums[j];
+            Rational made[6];
+            bool ok[6] = {add(a, b, made[0]), mul(a, b, made[1]), sub(a, b, made[2]), sub(b, a, made[3]),
+                          b.num != 0 && div(a, b, made[4]), a.num != 0 && div(b, a, made[5])};
+            for(int o = 0; o < 6; o++){
+                if(!ok[o]) continue;
+                rest.push_back(made[o]);
+                if(reaches(rest, target)) return true;
+                rest.pop_back();
+            }
+        }
+    }
+    return false;
+}
+
+static bool answers(const unknown::Answer& answer, const Rational& x){
+    if(std::binary_search(answer.values.begin(), answer.values.end(), x)) return true;
+    return answer.any && std::find(answer.except.begin(), answer.except.end(), x) == answer.except.end();
+}
+
+static void check_hand(const std::vector<int>& known, long long target){
+    unknown::Answer answer = unknown::solve(known, target);
+    std::vector<Rational> hand = reach::to_rationals(known);
+    hand.push_back(Rational(0));
+    //every answer is right, and no x among small integers and halves and thirds is missed
+    for(size_t i = 0; i < answer.values.size(); i++){
+        hand.back() = answer.values[i];
+        CHECK(reaches(hand, Rational(target)));
+    }
+    for(long long den = 1; den <= 3; den++){
+        for(long long num = -30 * den; num <= 60 * den; num++){
+            Rational x(num, den);
+            if(den > 1 && x.den == 1) continue;
+            hand.back() = x;
+            CHECK(answers(answer, x) == reaches(hand, Rational(target)));
+        }
+    }
+}
+
+int main(){
+    //0 * x + 24 makes 24 for any x
+    CHECK(unknown::solve(std::vector<int>{0, 24}, 24).any);
+    check_hand({0, 24}, 24);
+    check_hand({}, 24);
+    check_hand({3, 8}, 24);
+    uint64_t state = 5;
+    for(int round = 0; round < 40; round++){
+        std::vector<int> known;
+        int n = 1 + (int)(test_rng(state) % 3);
+        for(int i = 0; i < n; i++) known.push_back((int)(test_rng(state) % 14));
+        check_hand(known, round % 2 ? 24 : (long long)(test_rng(state) % 40) - 10);
+    }
+    return test_exit("unknown_test");
+}